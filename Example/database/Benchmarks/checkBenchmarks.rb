@@ -0,0 +1,70 @@
+#!/usr/bin/env ruby
+#
+# Compare the results written by JPDBManagerBenchmarks.m with the committed baselines.
+#
+#   ruby checkBenchmarks.rb results.json baseline.json             Fail if some metric regressed.
+#   ruby checkBenchmarks.rb results.json baseline.json --update    Record the results as the new baseline.
+#
+# Latencies (p50, p95, p99, mean, seconds) regress when they grow, throughputs (rowsPerSecond) when they drop.
+# The tolerance is read from the baseline file, default is 20%. Metrics without baseline fail the check, record
+# them first with --update on the reference device. While the baseline has no dataset at all the check only
+# reports the results and passes, so the benchmarks can run before the first baseline is recorded.
+#
+require 'json'
+
+results_path, baseline_path, option = ARGV
+abort "Usage: ruby #{$0} results.json baseline.json [--update]" unless results_path && baseline_path
+
+results = JSON.parse(File.read(results_path))
+
+if option == '--update'
+  baseline = File.exist?(baseline_path) ? JSON.parse(File.read(baseline_path)) : {}
+  baseline['device'] = results['device']
+  baseline['system'] = results['system']
+  baseline['datasets'] = results['datasets']
+  File.write(baseline_path, JSON.pretty_generate(baseline) + "\n")
+  puts "Baseline updated from #{results_path}."
+  exit
+end
+
+abort "No baseline at #{baseline_path}, record one with --update." unless File.exist?(baseline_path)
+
+baseline = JSON.parse(File.read(baseline_path))
+tolerance = baseline.fetch('tolerance', 0.2)
+record_only = baseline.fetch('datasets', {}).empty?
+regressions = []
+missing = []
+
+results['datasets'].sort_by { |size, _| size.to_i }.each do |size, operations|
+  operations.sort.each do |operation, metrics|
+    metrics.sort.each do |metric, value|
+      expected = baseline.dig('datasets', size, operation, metric)
+      label = "#{size} rows / #{operation} / #{metric}"
+
+      if expected.nil? || expected.zero?
+        missing << label
+        puts format('? %-45s %12.6f  no baseline', label, value)
+        next
+      end
+
+      change = (value - expected) / expected
+      change = -change if metric == 'rowsPerSecond'
+
+      regressed = change > tolerance
+      regressions << label if regressed
+      puts format('%s %-45s %12.6f  baseline %12.6f  %+6.1f%%', regressed ? '!' : ' ', label, value, expected, change * 100)
+    end
+  end
+end
+
+if record_only
+  puts "No baseline recorded yet, nothing compared. Record one with --update on the reference device."
+  exit
+end
+
+failures = []
+failures << "#{missing.count} metric(s) without baseline, record them with --update:\n  " + missing.join("\n  ") unless missing.empty?
+failures << "#{regressions.count} regression(s) above #{(tolerance * 100).round}%:\n  " + regressions.join("\n  ") unless regressions.empty?
+
+abort failures.join("\n") unless failures.empty?
+puts "No regressions (tolerance #{(tolerance * 100).round}%)."
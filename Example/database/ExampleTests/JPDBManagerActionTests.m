@@ -4,6 +4,8 @@
 
 #import "JPDBManager.h"
 #import "JPDBManagerAction.h"
+#import "JPDBManagerAsyncQuery.h"
+#import "JPDBManagerCursor.h"
 
 SPEC_BEGIN(DatabaseAction)
 
@@ -473,6 +475,325 @@ describe(@"Database Action", ^{
 
     ////////// ///////// ///////// ///////// ///////// ///////// ///////// ///////// ///////// /////////
 
+    context(@"Partial Properties", ^{
+
+        beforeEach(^{
+            [entity stub:@selector(propertiesByName) andReturn:@{@"name" : any(), @"age" : any()}];
+        });
+
+        it(@"Should fetch only some properties as dictionaries", ^{
+            [action applyPropertiesToFetch:@[@"name", @"age"]];
+
+            [[theValue(action.returnsDictionaries) should] beYes];
+            [[theValue(action.resultType) should] equal:theValue(NSDictionaryResultType)];
+            [[action.propertiesToFetch should] equal:@[@"name", @"age"]];
+        });
+
+
+
+
+        it(@"Should fail to fetch a property that doesn't exist", ^{
+            [[theBlock(^{
+                [action applyPropertiesToFetch:@[@"unknown"]];
+            }) should] raiseWithName:JPDBManagerActionException];
+        });
+
+
+
+
+        it(@"Should query the plain values of one property", ^{
+            [manager stub:@selector(performDatabaseAction:)
+
+                withBlock:^id(NSArray *params) {
+                    JPDBManagerAction *query = params[0];
+
+                    [[query.propertiesToFetch should] equal:@[@"name"]];
+                    [[theValue(query.returnsDistinctResults) should] beYes];
+
+                    return @[@{@"name" : @"John"}, @{}, @{@"name" : @"Mary"}];
+                }
+            ];
+
+            [[[action queryValuesOfKey:@"name" distinct:YES] should] equal:@[@"John", @"Mary"]];
+        });
+
+    });
+
+    ////////// ///////// ///////// ///////// ///////// ///////// ///////// ///////// ///////// /////////
+
+    context(@"Prefetch Relationships", ^{
+
+        beforeEach(^{
+            [entity stub:@selector(relationshipsByName) andReturn:@{@"customer" : any(), @"items" : any()}];
+        });
+
+        it(@"Should prefetch the relationships", ^{
+            [action applyPrefetchRelationships:@[@"customer", @"items.product"]];
+
+            [[action.relationshipKeyPathsForPrefetching should] equal:@[@"customer", @"items.product"]];
+        });
+
+
+
+
+        it(@"Should fail to prefetch a relationship that doesn't exist", ^{
+            [[theBlock(^{
+                [action applyPrefetchRelationships:@[@"unknown"]];
+            }) should] raiseWithName:JPDBManagerActionException];
+        });
+
+    });
+
+    ////////// ///////// ///////// ///////// ///////// ///////// ///////// ///////// ///////// /////////
+
+    context(@"Cursor Pagination", ^{
+
+        it(@"Should query each page after the last record of the previous one", ^{
+            __block NSPredicate *lastPredicate;
+
+            [manager stub:@selector(performDatabaseAction:)
+
+                withBlock:^id(NSArray *params) {
+                    JPDBManagerAction *query = params[0];
+
+                    [[theValue(query.fetchLimit) should] equal:theValue(3)];
+                    [[theValue(query.fetchOffset) should] equal:theValue(0)];
+                    lastPredicate = query.predicate;
+
+                    // One more than the page size.
+                    return @[@{@"date" : @1, @"id" : @10}, @{@"date" : @2, @"id" : @20}, @{@"date" : @2, @"id" : @30}];
+                }
+            ];
+
+            [action applySortDescriptors:@[
+                    [NSSortDescriptor sortDescriptorWithKey:@"date" ascending:NO],
+                    [NSSortDescriptor sortDescriptorWithKey:@"id" ascending:YES]
+            ]];
+
+            JPDBManagerCursor *cursor = [JPDBManagerCursor initWithPageSize:2];
+
+            [[[action nextPageAfterCursor:cursor] should] haveCountOf:2];
+            [[lastPredicate should] beNil];
+            [[theValue(cursor.hasMorePages) should] beYes];
+            [[cursor.lastValues should] equal:@[@2, @20]];
+
+            [action nextPageAfterCursor:cursor];
+            [[lastPredicate.predicateFormat should] equal:@"date < 2 OR (date == 2 AND id > 20)"];
+        });
+
+
+
+
+        it(@"Should compare the last record the same way the records are sorted", ^{
+            __block NSPredicate *lastPredicate;
+
+            [manager stub:@selector(performDatabaseAction:)
+
+                withBlock:^id(NSArray *params) {
+                    lastPredicate = [params[0] predicate];
+                    return @[@{@"name" : @"Ann"}, @{@"name" : @"bob"}];
+                }
+            ];
+
+            [action applySortDescriptors:@[
+                    [NSSortDescriptor sortDescriptorWithKey:@"name" ascending:YES selector:@selector(caseInsensitiveCompare:)]
+            ]];
+
+            JPDBManagerCursor *cursor = [JPDBManagerCursor initWithPageSize:1];
+            [action nextPageAfterCursor:cursor];
+            [action nextPageAfterCursor:cursor];
+
+            [[lastPredicate.predicateFormat should] equal:@"name >[c] \"Ann\""];
+        });
+
+
+
+
+        it(@"Should fail to paginate sorted by one selector it can't compare", ^{
+            [action applySortDescriptors:@[
+                    [NSSortDescriptor sortDescriptorWithKey:@"name" ascending:YES selector:@selector(localizedStandardCompare:)]
+            ]];
+
+            [[theBlock(^{
+                [action nextPageAfterCursor:[JPDBManagerCursor initWithPageSize:2]];
+            }) should] raiseWithName:JPDBManagerActionException];
+        });
+
+
+
+
+        it(@"Should use the default page size instead of empty pages", ^{
+            [[theValue([JPDBManagerCursor initWithPageSize:0].pageSize) should] equal:theValue(JPDBManagerDefaultPageSize)];
+        });
+
+
+
+
+        it(@"Should fail to paginate without sort descriptors", ^{
+            [[theBlock(^{
+                [action nextPageAfterCursor:[JPDBManagerCursor initWithPageSize:2]];
+            }) should] raiseWithName:JPDBManagerActionException];
+        });
+
+    });
+
+    ////////// ///////// ///////// ///////// ///////// ///////// ///////// ///////// ///////// /////////
+
+    context(@"Batch Enumeration", ^{
+
+        beforeEach(^{
+            #pragma clang diagnostic push
+            #pragma clang diagnostic ignored "-Wundeclared-selector"
+
+            // The manager return 5 Object IDs, and after that the records of each batch.
+            [manager stub:@selector(performDatabaseAction:)
+
+                withBlock:^id(NSArray *params) {
+                    JPDBManagerAction *query = params[0];
+
+                    if (query.resultType == NSManagedObjectIDResultType) {
+                        // Only one batch of Object IDs is queried at a time.
+                        [[theValue(query.fetchLimit) should] beBetween:theValue(1) and:theValue(2)];
+
+                        NSArray *objectIDs = @[@1, @2, @3, @4, @5];
+                        NSUInteger offset = MIN(query.fetchOffset, [objectIDs count]);
+                        NSUInteger length = [objectIDs count] - offset;
+                        if (query.fetchLimit > 0)
+                            length = MIN(length, query.fetchLimit);
+
+                        return [objectIDs subarrayWithRange:NSMakeRange(offset, length)];
+                    }
+
+                    // Batches are queried whole, return the IDs of this batch as the records.
+                    [[theValue(query.fetchLimit) should] equal:theValue(0)];
+                    [[theValue(query.fetchOffset) should] equal:theValue(0)];
+                    return [(NSComparisonPredicate *) query.predicate rightExpression].constantValue;
+                }
+            ];
+            [manager stub:@selector(refaultRecords:)];
+
+            #pragma clang diagnostic pop
+        });
+
+        it(@"Should enumerate all records in batches", ^{
+            __block NSUInteger batches = 0;
+
+            [action enumerateInBatchesOfSize:2 usingBlock:^(NSArray *batch, BOOL *stop) {
+                [[@([batch count]) should] equal:@(batches < 2 ? 2 : 1)];
+                batches++;
+            }];
+
+            [[@(batches) should] equal:@3];
+        });
+
+
+
+
+        it(@"Should respect the fetch limits of the action", ^{
+            NSMutableArray *records = [NSMutableArray array];
+
+            [action setFetchOffset:1 setFetchLimit:3];
+            [action enumerateInBatchesOfSize:2 usingBlock:^(NSArray *batch, BOOL *stop) {
+                [records addObjectsFromArray:batch];
+            }];
+
+            [[records should] equal:@[@2, @3, @4]];
+        });
+
+
+
+
+        it(@"Should stop the enumeration when asked", ^{
+            __block NSUInteger batches = 0;
+
+            [action enumerateInBatchesOfSize:2 usingBlock:^(NSArray *batch, BOOL *stop) {
+                batches++;
+                *stop = YES;
+            }];
+
+            [[@(batches) should] equal:@1];
+        });
+
+    });
+
+    ////////// ///////// ///////// ///////// ///////// ///////// ///////// ///////// ///////// /////////
+
+    context(@"Asynchronous Query", ^{
+
+        __block id mainContext;
+        __block id poolContext;
+
+        beforeEach(^{
+            mainContext = [KWMock nullMockForClass:[NSManagedObjectContext class]];
+            poolContext = [KWMock nullMockForClass:[NSManagedObjectContext class]];
+
+            [manager stub:@selector(managedObjectContext) andReturn:mainContext];
+
+            // Run the background block right away on the pool context.
+            [manager stub:@selector(performBlock:) withBlock:^id(NSArray *params) {
+                void (^block)(NSManagedObjectContext *) = params[0];
+                block(poolContext);
+                return nil;
+            }];
+        });
+
+        it(@"Should query the Object IDs on background and deliver the records on the main queue", ^{
+            __block NSArray *records;
+            __block NSUInteger fetches = 0;
+
+            id firstRecord = [KWMock nullMockForClass:[NSManagedObject class]];
+            id secondRecord = [KWMock nullMockForClass:[NSManagedObject class]];
+            [firstRecord stub:@selector(objectID) andReturn:@"1"];
+            [secondRecord stub:@selector(objectID) andReturn:@"2"];
+
+            [manager stub:@selector(performDatabaseAction:)
+
+                withBlock:^id(NSArray *params) {
+                    JPDBManagerAction *query = params[0];
+
+                    // Object IDs on the pool.
+                    if (query.resultType == NSManagedObjectIDResultType) {
+                        [[query.context should] equal:poolContext];
+                        return @[@"1", @"2"];
+                    }
+
+                    // All records in one fetch on the main context, in any order.
+                    fetches++;
+                    [[query.context should] equal:mainContext];
+                    [[query.predicate should] equal:[NSPredicate predicateWithFormat:@"self IN %@", @[@"1", @"2"]]];
+
+                    return @[secondRecord, firstRecord];
+                }
+            ];
+
+            [action runAsync:^(NSArray *result) {
+                [[theValue([NSThread isMainThread]) should] beYes];
+                records = result;
+            }];
+
+            [[expectFutureValue(records) shouldEventually] equal:@[firstRecord, secondRecord]];
+            [[@(fetches) should] equal:@1];
+        });
+
+
+
+
+        it(@"Should not deliver a cancelled query", ^{
+            __block BOOL delivered = NO;
+
+            [manager stub:@selector(performDatabaseAction:) andReturn:@[@"1"]];
+
+            [[action runAsync:^(NSArray *result) {
+                delivered = YES;
+            }] cancel];
+
+            [[expectFutureValue(theValue(delivered)) shouldAfterWaitOf(0.5)] beNo];
+        });
+
+    });
+
+    ////////// ///////// ///////// ///////// ///////// ///////// ///////// ///////// ///////// /////////
+
     context(@"Remove Data", ^{
 
         // All remove methods concatenate to call one final method, we'll stub and expect data from him
@@ -482,18 +803,49 @@ describe(@"Database Action", ^{
         // Mock data object to delete.
         __block id dataObject = [KWMock mockForClass:[NSManagedObject class]];
 
+        // Context of the pool where the batched deletes run.
+        __block id poolContext;
+
         beforeEach(^{
             // Stub the final method.
             [action stub:finalMethod];
+
+            poolContext = [KWMock nullMockForClass:[NSManagedObjectContext class]];
+            [manager stub:@selector(performBlockAndWait:) withBlock:^id(NSArray *params) {
+                void (^block)(NSManagedObjectContext *) = params[0];
+                block(poolContext);
+                return nil;
+            }];
         });
 
+        // The manager return these Object IDs to delete.
+        void (^stubObjectIDs)(NSArray *) = ^(NSArray *objectIDs) {
+            #pragma clang diagnostic push
+            #pragma clang diagnostic ignored "-Wundeclared-selector"
+
+            [manager stub:@selector(performDatabaseAction:) withBlock:^id(NSArray *params) {
+                JPDBManagerAction *query = params[0];
+                [[theValue(query.resultType) should] equal:theValue(NSManagedObjectIDResultType)];
+                [[query.context should] beIdenticalTo:poolContext];
+                return objectIDs;
+            }];
+            [manager stub:@selector(deleteRecordsWithIDs:fromAction:)];
+            [manager stub:@selector(commitContext:)];
+
+            #pragma clang diagnostic pop
+        };
+
         it(@"Should delete all Records from specified entityName", ^{
-            // Stub internal query to return our data object.
-            [action stub:@selector(queryWithFetchTemplate:) andReturn:@[dataObject]];
+            #pragma clang diagnostic push
+            #pragma clang diagnostic ignored "-Wundeclared-selector"
 
-            // Delete all.
-            [[action should] receive:finalMethod withArguments:dataObject, [KWValue valueWithBool:NO]];
-            [action deleteAllRecords];
+            stubObjectIDs(@[@1, @2, @3]);
+
+            // Delete all, without loading any record.
+            [[manager should] receive:@selector(deleteRecordsWithIDs:fromAction:) withArguments:@[@1, @2, @3], any()];
+            [[@([action deleteAllRecords]) should] equal:@3];
+
+            #pragma clang diagnostic pop
         });
 
 
@@ -501,13 +853,36 @@ describe(@"Database Action", ^{
 
 
         it(@"Shoul delete all records queried by the specified Fetch Template", ^{
-            // Stub internal query to return our data object.
-            [action stub:@selector(queryWithFetchTemplate:) andReturn:@[dataObject]
-            withArguments:__fetchTemplate];
+            #pragma clang diagnostic push
+            #pragma clang diagnostic ignored "-Wundeclared-selector"
+
+            stubObjectIDs(@[@1]);
 
             // Delete all.
-            [[action should] receive:finalMethod withArguments:dataObject, [KWValue valueWithBool:NO]];
+            [[manager should] receive:@selector(deleteRecordsWithIDs:fromAction:) withArguments:@[@1], any()];
             [action deleteRecordsWithFetchTemplate:__fetchTemplate];
+            [[action.fetchTemplate should] equal:__fetchTemplate];
+
+            #pragma clang diagnostic pop
+        });
+
+
+
+
+
+        it(@"Should delete and commit in bounded batches", ^{
+            #pragma clang diagnostic push
+            #pragma clang diagnostic ignored "-Wundeclared-selector"
+
+            stubObjectIDs(@[@1, @2, @3, @4, @5]);
+
+            // One delete and one commit of the pool context per batch. The main context isn't committed.
+            [[manager should] receive:@selector(deleteRecordsWithIDs:fromAction:) withCount:3];
+            [[manager should] receive:@selector(commitContext:) withCount:3 arguments:poolContext];
+            [[manager shouldNot] receive:@selector(commit)];
+            [[@([action deleteRecordsInBatchesOfSize:2]) should] equal:@5];
+
+            #pragma clang diagnostic pop
         });
 
         
@@ -528,14 +903,20 @@ describe(@"Database Action", ^{
         it(@"Should delete an record of database, final call", ^{
             id dataObject = [KWMock mockForClass:[NSManagedObject class]];
 
+            #pragma clang diagnostic push
+            #pragma clang diagnostic ignored "-Wundeclared-selector"
+
             // Stub the manager to receive internal calls.
             [manager stub:@selector(deleteRecord:)];
-            [manager stub:@selector(commit)];
+            [manager stub:@selector(scheduleCommit)];
 
+            // Single writes go through the group commit scheduler.
             [[manager should] receive:@selector(deleteRecord:) withArguments:dataObject];
-            [[manager should] receive:@selector(commit)];
+            [[manager should] receive:@selector(scheduleCommit)];
 
             [action deleteRecord:dataObject andCommit:YES];
+
+            #pragma clang diagnostic pop
         });
 
     });
@@ -562,6 +943,79 @@ describe(@"Database Action", ^{
             
             #pragma clang diagnostic pop
         });
+
+
+
+
+        it(@"Should import records in batches, mapping keys and converting values", ^{
+            #pragma clang diagnostic push
+            #pragma clang diagnostic ignored "-Wundeclared-selector"
+
+            // The Entity has one 'name' string attribute.
+            id attribute = [KWMock mockForClass:[NSAttributeDescription class]];
+            [attribute stub:@selector(attributeType) andReturn:theValue(NSStringAttributeType)];
+            [entity stub:@selector(attributesByName) andReturn:@{@"name" : attribute}];
+
+            // Records are created as mutable dictionaries.
+            NSMutableArray *created = [NSMutableArray new];
+            [manager stub:@selector(createNewRecordFromAction:) withBlock:^id(NSArray *params) {
+                NSMutableDictionary *record = [NSMutableDictionary new];
+                [created addObject:record];
+                return record;
+            }];
+            [manager stub:@selector(refaultRecords:)];
+
+            // Records are imported on one context of the pool, with one commit per batch.
+            id poolContext = [KWMock nullMockForClass:[NSManagedObjectContext class]];
+            [manager stub:@selector(performBlockAndWait:) withBlock:^id(NSArray *params) {
+                void (^block)(NSManagedObjectContext *) = params[0];
+                block(poolContext);
+                return nil;
+            }];
+            [manager stub:@selector(commitContext:)];
+            [[manager should] receive:@selector(commitContext:) withCount:2 arguments:poolContext];
+
+            __block NSUInteger lastProgress = 0;
+            NSUInteger imported = [[action applyImportKeyMap:@{@"title" : @"name"}]
+                    importRecords:@[@{@"title" : @1}, @{@"name" : @"B"}, @{@"name" : @"C", @"unknown" : @0}]
+                  inBatchesOfSize:2
+                         progress:^(NSUInteger importedCount, double recordsPerSecond, BOOL *stop) {
+                             lastProgress = importedCount;
+                         }];
+
+            [[@(imported) should] equal:@3];
+            [[@(lastProgress) should] equal:@3];
+            [[created should] equal:@[@{@"name" : @"1"}, @{@"name" : @"B"}, @{@"name" : @"C"}]];
+
+            #pragma clang diagnostic pop
+        });
+
+
+
+
+
+        it(@"Should fail to import records that aren't dictionaries", ^{
+            #pragma clang diagnostic push
+            #pragma clang diagnostic ignored "-Wundeclared-selector"
+
+            [entity stub:@selector(attributesByName) andReturn:@{}];
+            [manager stub:@selector(createNewRecordFromAction:) andReturn:[NSMutableDictionary new]];
+
+            // The batch being imported is discarded.
+            id poolContext = [KWMock nullMockForClass:[NSManagedObjectContext class]];
+            [manager stub:@selector(performBlockAndWait:) withBlock:^id(NSArray *params) {
+                void (^block)(NSManagedObjectContext *) = params[0];
+                block(poolContext);
+                return nil;
+            }];
+            [[poolContext should] receive:@selector(rollback)];
+
+            [[theBlock(^{
+                [action importRecords:@[@{}, @"not a record"]];
+            }) should] raiseWithName:JPDBManagerActionException];
+
+            #pragma clang diagnostic pop
+        });
         
     });
 
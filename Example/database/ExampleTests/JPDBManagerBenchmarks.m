@@ -0,0 +1,243 @@
+#import "Kiwi.h"
+
+#import "JPDBManager.h"
+#import "JPDBManagerAction.h"
+
+//
+// Database benchmarks. They're slow, so they only run when the JPDB_BENCHMARK environment variable is defined,
+// see runBenchmarks.sh. Results are written as JSON to JPDB_BENCHMARK_OUTPUT and compared with the committed
+// baselines by Benchmarks/checkBenchmarks.rb.
+//
+//  JPDB_BENCHMARK_SIZES   Comma separated dataset sizes. Default is 10000,100000,1000000.
+//  JPDB_BENCHMARK_OUTPUT  Where the results are written. Default is benchmark-results.json on the temporary directory.
+//
+
+#define __benchmarkEntity      @"BenchmarkRecord"
+#define __benchmarkIterations  50
+
+// Manager writing his store on a temporary file.
+@interface JPDBBenchmarkManager : JPDBManager
+@end
+
+@implementation JPDBBenchmarkManager
+
+- (NSURL *)SQLiteFilePath {
+    return [NSURL fileURLWithPath:[NSTemporaryDirectory() stringByAppendingPathComponent:@"benchmark.sqlite"]];
+}
+
+@end
+
+// Generate the rows of one dataset lazily, so huge datasets doesn't need to fit on memory.
+@interface JPDBBenchmarkRows : NSEnumerator
+@property(assign) NSUInteger count;
+@property(assign) NSUInteger next;
+@end
+
+@implementation JPDBBenchmarkRows
+
+- (id)nextObject {
+    if (self.next >= self.count)
+        return nil;
+
+    NSUInteger identifier = self.next++;
+    return @{
+            @"identifier" : @(identifier),
+            @"name"       : [NSString stringWithFormat:@"Record %lu", (unsigned long) identifier],
+            @"score"      : @((identifier * 7919 % 10007) / 10007.0),
+            @"createdAt"  : [NSDate dateWithTimeIntervalSince1970:identifier]
+    };
+}
+
+@end
+
+////////// ///////// ///////// ///////// ///////// ///////// ///////// ///////// ///////// /////////
+
+// Model created on runtime, with the attribute types more used on real models.
+static NSManagedObjectModel *JPDBBenchmarkModel() {
+    NSEntityDescription *entity = [NSEntityDescription new];
+    entity.name = __benchmarkEntity;
+    entity.managedObjectClassName = NSStringFromClass([NSManagedObject class]);
+
+    NSMutableArray *properties = [NSMutableArray array];
+    NSDictionary *attributes = @{
+            @"identifier" : @(NSInteger64AttributeType),
+            @"name"       : @(NSStringAttributeType),
+            @"score"      : @(NSDoubleAttributeType),
+            @"createdAt"  : @(NSDateAttributeType)
+    };
+
+    [attributes enumerateKeysAndObjectsUsingBlock:^(NSString *name, NSNumber *type, BOOL *stop) {
+        NSAttributeDescription *attribute = [NSAttributeDescription new];
+        attribute.name = name;
+        attribute.attributeType = (NSAttributeType) [type unsignedIntegerValue];
+        attribute.optional = YES;
+        attribute.indexed = [name isEqualToString:@"identifier"] || [name isEqualToString:@"score"];
+        [properties addObject:attribute];
+    }];
+
+    entity.properties = properties;
+
+    NSManagedObjectModel *model = [NSManagedObjectModel new];
+    model.entities = @[entity];
+    return model;
+}
+
+// Run one block some times and return the latency percentiles, in seconds.
+static NSDictionary *JPDBBenchmarkLatency(NSUInteger iterations, void (^block)(NSUInteger iteration)) {
+    NSMutableArray *durations = [NSMutableArray arrayWithCapacity:iterations];
+
+    for (NSUInteger i = 0; i < iterations; i++) {
+        @autoreleasepool {
+            CFAbsoluteTime start = CFAbsoluteTimeGetCurrent();
+            block(i);
+            [durations addObject:@(CFAbsoluteTimeGetCurrent() - start)];
+        }
+    }
+
+    [durations sortUsingSelector:@selector(compare:)];
+    NSNumber *(^percentile)(double) = ^NSNumber *(double rank) {
+        return durations[MIN((NSUInteger) (rank * iterations), iterations - 1)];
+    };
+
+    return @{
+            @"p50"  : percentile(0.50),
+            @"p95"  : percentile(0.95),
+            @"p99"  : percentile(0.99),
+            @"mean" : [durations valueForKeyPath:@"@avg.self"]
+    };
+}
+
+// Run one block once and return his duration and throughput.
+static NSDictionary *JPDBBenchmarkThroughput(NSUInteger rows, void (^block)(void)) {
+    CFAbsoluteTime start = CFAbsoluteTimeGetCurrent();
+    @autoreleasepool {
+        block();
+    }
+    NSTimeInterval seconds = CFAbsoluteTimeGetCurrent() - start;
+
+    return @{
+            @"seconds"       : @(seconds),
+            @"rowsPerSecond" : @(seconds > 0 ? rows / seconds : 0)
+    };
+}
+
+static NSDictionary *JPDBBenchmarkDataset(NSManagedObjectModel *model, NSUInteger size) {
+    NSMutableDictionary *results = [NSMutableDictionary dictionary];
+
+    // Always start from an empty store.
+    JPDBBenchmarkManager *manager = [JPDBBenchmarkManager new];
+    [[NSFileManager defaultManager] removeItemAtURL:[manager SQLiteFilePath] error:NULL];
+    [manager startCoreDataWithManagedObjectModel:model];
+
+    NSManagedObjectContext *context = manager.managedObjectContext;
+    JPDBManagerAction *(^action)(void) = ^{
+        return [manager getDatabaseActionForEntity:__benchmarkEntity];
+    };
+
+    ////// ////// //////
+    // Insert.
+    results[@"insert"] = JPDBBenchmarkThroughput(size, ^{
+        JPDBBenchmarkRows *rows = [JPDBBenchmarkRows new];
+        rows.count = size;
+        [action() importRecords:rows inBatchesOfSize:0 progress:nil];
+    });
+    [context reset];
+
+    ////// ////// //////
+    // Query about 1% of the records.
+    results[@"query"] = JPDBBenchmarkLatency(__benchmarkIterations, ^(NSUInteger iteration) {
+        double from = iteration / (double) __benchmarkIterations;
+        [[action() applyPredicate:[NSPredicate predicateWithFormat:@"score >= %@ AND score < %@", @(from), @(from + 0.01)]] run];
+        [context reset];
+    });
+
+    ////// ////// //////
+    // Sorted query, first page.
+    results[@"sortedQuery"] = JPDBBenchmarkLatency(__benchmarkIterations, ^(NSUInteger iteration) {
+        JPDBManagerAction *sorted = [action() applySortDescriptors:@[[NSSortDescriptor sortDescriptorWithKey:@"score" ascending:NO]]];
+        [sorted setFetchOffset:0 setFetchLimit:100];
+        [sorted run];
+        [context reset];
+    });
+
+    ////// ////// //////
+    // Count.
+    results[@"count"] = JPDBBenchmarkLatency(__benchmarkIterations, ^(NSUInteger iteration) {
+        [[action() applyPredicate:[NSPredicate predicateWithFormat:@"score > %@", @0.5]] countRecords];
+    });
+
+    ////// ////// //////
+    // Find by key, spread over the whole dataset.
+    results[@"find"] = JPDBBenchmarkLatency(__benchmarkIterations, ^(NSUInteger iteration) {
+        [action() queryRecordWithKey:@"identifier" value:@(iteration * 7919 % size)];
+        [context reset];
+    });
+
+    ////// ////// //////
+    // Commit one update on 1% of the records.
+    NSUInteger updated = MAX(size / 100, 1);
+    JPDBManagerAction *toUpdate = action();
+    [toUpdate setFetchOffset:0 setFetchLimit:(int) updated];
+    for (NSManagedObject *record in [toUpdate run])
+        [record setValue:@0 forKey:@"score"];
+
+    results[@"commit"] = JPDBBenchmarkThroughput(updated, ^{
+        [manager commitAndWait];
+    });
+    [context reset];
+
+    ////// ////// //////
+    // Delete all.
+    results[@"deleteAll"] = JPDBBenchmarkThroughput(size, ^{
+        JPDBManagerAction *all = action();
+        all.commitTransaction = YES;
+        [all deleteAllRecords];
+    });
+
+    [manager closeCoreData];
+    [[NSFileManager defaultManager] removeItemAtURL:[manager SQLiteFilePath] error:NULL];
+
+    return results;
+}
+
+////////// ///////// ///////// ///////// ///////// ///////// ///////// ///////// ///////// /////////
+
+SPEC_BEGIN(DatabaseBenchmarks)
+
+describe(@"Database Benchmarks", ^{
+
+    NSDictionary *environment = [[NSProcessInfo processInfo] environment];
+
+    if (!environment[@"JPDB_BENCHMARK"])
+        return;
+
+    it(@"Should measure every operation on every dataset size", ^{
+        NSString *sizes = environment[@"JPDB_BENCHMARK_SIZES"] ?: @"10000,100000,1000000";
+        NSString *output = environment[@"JPDB_BENCHMARK_OUTPUT"]
+                ?: [NSTemporaryDirectory() stringByAppendingPathComponent:@"benchmark-results.json"];
+
+        NSManagedObjectModel *model = JPDBBenchmarkModel();
+        NSMutableDictionary *datasets = [NSMutableDictionary dictionary];
+
+        for (NSString *size in [sizes componentsSeparatedByString:@","]) {
+            NSUInteger count = (NSUInteger) [size integerValue];
+            if (count > 0)
+                datasets[[@(count) stringValue]] = JPDBBenchmarkDataset(model, count);
+        }
+
+        NSDictionary *results = @{
+                @"device"   : [[UIDevice currentDevice] model],
+                @"system"   : [[UIDevice currentDevice] systemVersion],
+                @"date"     : [[NSDate date] description],
+                @"datasets" : datasets
+        };
+
+        NSData *json = [NSJSONSerialization dataWithJSONObject:results options:NSJSONWritingPrettyPrinted error:NULL];
+        [[theValue([json writeToFile:output atomically:YES]) should] beYes];
+
+        NSLog(@"Benchmark results written to %@", output);
+    });
+
+});
+
+SPEC_END
@@ -0,0 +1,1130 @@
+#import "Kiwi.h"
+
+#import "JPDBManager.h"
+#import "JPDBManagerAction.h"
+#import "JPDBManagerChangeFeed.h"
+#import "JPDBManagerMemoryGovernor.h"
+#import "JPDBManagerMetadata.h"
+#import "JPDBManagerMetrics.h"
+#import "JPDBManagerQueryCache.h"
+#import "JPDBManagerStoreConfiguration.h"
+
+//
+// Database Manager specs. They run the real Core Data stack, with one model created on runtime
+// and in-memory stores, so every spec starts from an empty database.
+//
+
+#define __customerEntity  @"Customer"
+#define __orderEntity     @"Order"
+#define __eventEntity     @"Event"
+
+#define __customersNamedTemplate @"customersNamed"
+
+static NSAttributeDescription *JPDBTestAttribute(NSString *name, NSAttributeType type) {
+    NSAttributeDescription *attribute = [NSAttributeDescription new];
+    attribute.name = name;
+    attribute.attributeType = type;
+    attribute.optional = YES;
+    return attribute;
+}
+
+static NSEntityDescription *JPDBTestEntity(NSString *name) {
+    NSEntityDescription *entity = [NSEntityDescription new];
+    entity.name = name;
+    entity.managedObjectClassName = NSStringFromClass([NSManagedObject class]);
+    return entity;
+}
+
+// Customers have many Orders. Events are independent, they can go to one partition.
+static NSManagedObjectModel *JPDBTestModel() {
+    NSEntityDescription *customer = JPDBTestEntity(__customerEntity);
+    NSEntityDescription *order = JPDBTestEntity(__orderEntity);
+    NSEntityDescription *event = JPDBTestEntity(__eventEntity);
+
+    NSRelationshipDescription *orders = [NSRelationshipDescription new];
+    NSRelationshipDescription *owner = [NSRelationshipDescription new];
+
+    orders.name = @"orders";
+    orders.destinationEntity = order;
+    orders.inverseRelationship = owner;
+    orders.optional = YES;
+    orders.maxCount = 0;
+    orders.deleteRule = NSCascadeDeleteRule;
+
+    owner.name = @"customer";
+    owner.destinationEntity = customer;
+    owner.inverseRelationship = orders;
+    owner.optional = YES;
+    owner.maxCount = 1;
+
+    customer.properties = @[JPDBTestAttribute(@"name", NSStringAttributeType), orders];
+    // Negative numbers fail to save.
+    NSAttributeDescription *number = JPDBTestAttribute(@"number", NSInteger64AttributeType);
+    [number setValidationPredicates:@[[NSPredicate predicateWithFormat:@"SELF >= 0"]]
+             withValidationWarnings:@[@"Negative order number"]];
+
+    order.properties = @[number, owner];
+    event.properties = @[JPDBTestAttribute(@"name", NSStringAttributeType)];
+
+    NSManagedObjectModel *model = [NSManagedObjectModel new];
+    model.entities = @[customer, order, event];
+
+    NSFetchRequest *customersNamed = [NSFetchRequest new];
+    customersNamed.entity = customer;
+    customersNamed.predicate = [NSPredicate predicateWithFormat:@"name == $NAME"];
+    [model setFetchRequestTemplate:customersNamed forName:__customersNamedTemplate];
+
+    return model;
+}
+
+// Manager using in-memory stores, not started.
+static JPDBManager *JPDBTestManager() {
+    JPDBManager *manager = [JPDBManager new];
+    manager.storeConfiguration = [JPDBManagerStoreConfiguration configurationNamed:JPDBManagerStoreProfileInMemory];
+    return manager;
+}
+
+// Insert one record on the main context.
+static NSManagedObject *JPDBTestInsert(JPDBManager *manager, NSString *entityName, NSDictionary *values) {
+    NSManagedObject *record = [[manager getDatabaseActionForEntity:entityName] createNewRecord];
+    [record setValuesForKeysWithDictionary:values];
+    return record;
+}
+
+////////// ///////// ///////// ///////// ///////// ///////// ///////// ///////// ///////// /////////
+
+SPEC_BEGIN(DatabaseManager)
+
+describe(@"Database Manager", ^{
+
+    __block JPDBManager *manager;
+
+    beforeEach(^{
+        manager = JPDBTestManager();
+    });
+
+    afterEach(^{
+        [manager closeCoreData];
+    });
+
+    ////////// ///////// ///////// ///////// ///////// ///////// ///////// ///////// ///////// /////////
+
+    context(@"Store Configuration", ^{
+
+        it(@"Should translate his settings to SQLite pragmas", ^{
+            JPDBManagerStoreConfiguration *configuration = [JPDBManagerStoreConfiguration init];
+            configuration.journalMode = @"WAL";
+            configuration.synchronous = @"NORMAL";
+            configuration.cacheSize = -2048;
+            configuration.mmapSize = 1024;
+            configuration.pragmas = @{@"synchronous" : @"FULL", @"temp_store" : @"MEMORY"};
+
+            [[[configuration sqlitePragmas] should] equal:@{
+                    @"journal_mode" : @"WAL",
+                    @"synchronous"  : @"FULL",
+                    @"cache_size"   : @"-2048",
+                    @"mmap_size"    : @"1024",
+                    @"temp_store"   : @"MEMORY"
+            }];
+        });
+
+        it(@"Should have no pragmas by default", ^{
+            [[[[JPDBManagerStoreConfiguration init] sqlitePragmas] should] beEmpty];
+        });
+
+        it(@"Should build the store options", ^{
+            JPDBManagerStoreConfiguration *configuration = [JPDBManagerStoreConfiguration configurationNamed:JPDBManagerStoreProfileWriteHeavy];
+            configuration.readOnly = YES;
+
+            NSDictionary *options = [configuration storeOptions];
+            [[options[NSMigratePersistentStoresAutomaticallyOption] should] equal:@YES];
+            [[options[NSInferMappingModelAutomaticallyOption] should] equal:@YES];
+            [[options[NSReadOnlyPersistentStoreOption] should] equal:@YES];
+            [[options[NSSQLitePragmasOption] should] equal:@{@"journal_mode" : @"WAL", @"synchronous" : @"NORMAL"}];
+        });
+
+        it(@"Should pass pragmas only to SQLite stores", ^{
+            JPDBManagerStoreConfiguration *configuration = [JPDBManagerStoreConfiguration configurationNamed:JPDBManagerStoreProfileInMemory];
+            configuration.journalMode = @"WAL";
+            configuration.automaticMigration = NO;
+
+            [[[configuration storeOptions] should] beEmpty];
+        });
+
+        it(@"Should return copies of the registered profiles", ^{
+            JPDBManagerStoreConfiguration *custom = [JPDBManagerStoreConfiguration init];
+            custom.cacheSize = 100;
+            [JPDBManagerStoreConfiguration registerConfiguration:custom named:@"JPDBTestProfile"];
+            custom.cacheSize = 200;
+
+            JPDBManagerStoreConfiguration *registered = [JPDBManagerStoreConfiguration configurationNamed:@"JPDBTestProfile"];
+            [[theValue(registered.cacheSize) should] equal:theValue(100)];
+
+            registered.cacheSize = 300;
+            [[theValue([[JPDBManagerStoreConfiguration configurationNamed:@"JPDBTestProfile"] cacheSize]) should] equal:theValue(100)];
+            [[JPDBManagerStoreConfiguration configurationNamed:@"JPDBNoSuchProfile"] shouldBeNil];
+        });
+
+    });
+
+    ////////// ///////// ///////// ///////// ///////// ///////// ///////// ///////// ///////// /////////
+
+    context(@"Asynchronous Startup", ^{
+
+        __block BOOL finished;
+        __block NSError *startupError;
+
+        void (^start)(void) = ^{
+            finished = NO;
+            startupError = nil;
+            [manager startCoreDataAsyncWithManagedObjectModel:JPDBTestModel() completion:^(NSError *error) {
+                startupError = error;
+                finished = YES;
+            }];
+        };
+
+        it(@"Should open the store and create the main context", ^{
+            __block BOOL ready = NO;
+
+            start();
+            [manager performWhenReady:^{
+                ready = manager.managedObjectContext != nil;
+            }];
+
+            [[expectFutureValue(theValue(ready)) shouldEventually] beYes];
+            [[theValue(finished) should] beYes];
+            [startupError shouldBeNil];
+            [[theValue(manager.isReady) should] beYes];
+            [[manager.startupTimings[JPDBManagerStartupPhaseTotal] should] beNonNil];
+        });
+
+        it(@"Should refuse synchronous accesses on the main thread while starting", ^{
+            start();
+
+            [[theBlock(^{
+                [manager managedObjectContext];
+            }) should] raiseWithName:JPDBManagerStartException];
+
+            [[expectFutureValue(theValue(finished)) shouldEventually] beYes];
+        });
+
+        it(@"Should make background accesses wait for the startup", ^{
+            __block NSManagedObjectContext *background = nil;
+
+            start();
+            dispatch_async(dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^{
+                background = manager.managedObjectContext;
+            });
+
+            [[expectFutureValue(theValue(finished)) shouldEventually] beYes];
+            [[expectFutureValue(background) shouldEventually] beNonNil];
+
+            // The context created by the startup, on the main thread.
+            [[background should] beIdenticalTo:manager.managedObjectContext];
+            [[theValue(background.concurrencyType) shouldNot] equal:theValue(NSPrivateQueueConcurrencyType)];
+        });
+
+        it(@"Should report one failed startup, and start again", ^{
+            JPDBManagerStoreConfiguration *invalid = [JPDBManagerStoreConfiguration initWithStoreType:@"JPDBNoSuchStore"];
+            manager.storeConfiguration = invalid;
+
+            start();
+            [[expectFutureValue(theValue(finished)) shouldEventually] beYes];
+            [startupError shouldNotBeNil];
+            [[theValue(manager.isReady) should] beNo];
+
+            // Retry with a valid store.
+            manager.storeConfiguration = [JPDBManagerStoreConfiguration configurationNamed:JPDBManagerStoreProfileInMemory];
+
+            start();
+            [[expectFutureValue(theValue(finished)) shouldEventually] beYes];
+            [startupError shouldBeNil];
+            [[theValue(manager.isReady) should] beYes];
+        });
+
+    });
+
+    ////////// ///////// ///////// ///////// ///////// ///////// ///////// ///////// ///////// /////////
+
+    context(@"Context Pool", ^{
+
+        __block NSManagedObject *order;
+        __block NSManagedObjectID *orderID;
+
+        void (^startAndInsert)(void) = ^{
+            [manager startCoreDataWithManagedObjectModel:JPDBTestModel()];
+
+            order = JPDBTestInsert(manager, __orderEntity, @{@"number" : @1});
+            [manager commitAndWait];
+            orderID = order.objectID;
+        };
+
+        // Read one order from the store, on the pool.
+        NSDictionary *(^storedOrder)(void) = ^NSDictionary *{
+            __block NSDictionary *values = nil;
+            [manager performBlockAndWait:^(NSManagedObjectContext *context) {
+                NSManagedObject *stored = [context existingObjectWithID:orderID error:NULL];
+                [context refreshObject:stored mergeChanges:NO];
+                values = [stored dictionaryWithValuesForKeys:@[@"number", @"customer"]];
+            }];
+            return values;
+        };
+
+        it(@"Should merge the saves of the pool on the main context", ^{
+            startAndInsert();
+
+            [manager performBlockAndWait:^(NSManagedObjectContext *context) {
+                [[context objectWithID:orderID] setValue:@2 forKey:@"number"];
+            }];
+
+            [[expectFutureValue([order valueForKey:@"number"]) shouldEventually] equal:@2];
+        });
+
+        it(@"Should keep the saves of the pool when the writer context commits", ^{
+            manager.enableBackgroundCommit = YES;
+            startAndInsert();
+
+            [manager performBlockAndWait:^(NSManagedObjectContext *context) {
+                [[context objectWithID:orderID] setValue:@2 forKey:@"number"];
+            }];
+            [[expectFutureValue([order valueForKey:@"number"]) shouldEventually] equal:@2];
+
+            // The writer context saves the order again.
+            [order setValue:JPDBTestInsert(manager, __customerEntity, @{@"name" : @"Ann"}) forKey:@"customer"];
+            [manager commitAndWait];
+
+            NSDictionary *stored = storedOrder();
+            [[stored[@"number"] should] equal:@2];
+            [[stored[@"customer"] shouldNot] equal:[NSNull null]];
+        });
+
+    });
+
+    ////////// ///////// ///////// ///////// ///////// ///////// ///////// ///////// ///////// /////////
+
+    context(@"Metadata", ^{
+
+        __block NSManagedObjectModel *model;
+
+        // Events are mapped to one class of his own.
+        beforeEach(^{
+            model = JPDBTestModel();
+            [model.entitiesByName[__eventEntity] setManagedObjectClassName:@"JPDBTestEvent"];
+        });
+
+        it(@"Should accept the Entity name or the name of his class on every lookup", ^{
+            JPDBManagerMetadata *metadata = [JPDBManagerMetadata initWithModel:model];
+
+            [[[metadata entity:@"JPDBTestEvent"] should] beIdenticalTo:model.entitiesByName[__eventEntity]];
+            [[theValue([metadata existEntity:__eventEntity]) should] beYes];
+            [[theValue([metadata existEntity:@"JPDBTestEvent"]) should] beYes];
+            [[theValue([metadata existAttribute:@"name" inEntity:@"JPDBTestEvent"]) should] beYes];
+            [[theValue([metadata typeOfAttribute:@"name" inEntity:@"JPDBTestEvent"]) should] equal:theValue(NSStringAttributeType)];
+        });
+
+        it(@"Should not map the shared NSManagedObject class to any Entity", ^{
+            JPDBManagerMetadata *metadata = [JPDBManagerMetadata initWithModel:model];
+
+            [[metadata entity:NSStringFromClass([NSManagedObject class])] shouldBeNil];
+            [[theValue([metadata existEntity:NSStringFromClass([NSManagedObject class])]) should] beNo];
+            [[theValue([metadata existEntity:@"Unknown"]) should] beNo];
+        });
+
+        it(@"Should index attributes and relationships", ^{
+            JPDBManagerMetadata *metadata = [JPDBManagerMetadata initWithModel:model];
+
+            [[theValue([metadata typeOfAttribute:@"number" inEntity:__orderEntity]) should] equal:theValue(NSInteger64AttributeType)];
+            [[theValue([metadata typeOfAttribute:@"unknown" inEntity:__orderEntity]) should] equal:theValue(NSUndefinedAttributeType)];
+            [[theValue([metadata existAttribute:@"customer" inEntity:__orderEntity]) should] beNo];
+            [[[metadata destinationOfRelationship:@"orders" inEntity:__customerEntity] should] equal:__orderEntity];
+            [[metadata destinationOfRelationship:@"orders" inEntity:__orderEntity] shouldBeNil];
+        });
+
+        it(@"Should create actions for the class name of one Entity", ^{
+            [manager startCoreDataWithManagedObjectModel:model];
+
+            [[theValue([manager existEntity:@"JPDBTestEvent"]) should] beYes];
+            [[[manager getDatabaseActionForEntity:@"JPDBTestEvent"].entityName should] equal:__eventEntity];
+        });
+
+        it(@"Should answer lookups from many threads at once", ^{
+            [manager startCoreDataWithManagedObjectModel:model];
+
+            NSObject *lock = [NSObject new];
+            __block NSInteger found = 0;
+            dispatch_apply(16, dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^(size_t index) {
+                if ([manager existAttribute:@"name" inEntity:__customerEntity])
+                    @synchronized (lock) { found++; }
+            });
+
+            [[theValue(found) should] equal:theValue(16)];
+        });
+
+    });
+
+    ////////// ///////// ///////// ///////// ///////// ///////// ///////// ///////// ///////// /////////
+
+    context(@"Group Commit", ^{
+
+        __block JPDBManagerAction *customers;
+
+        // Delete one record, asking for one commit.
+        void (^write)(void) = ^{
+            NSManagedObject *customer = JPDBTestInsert(manager, __customerEntity, @{@"name" : @"Ann"});
+            [customers deleteRecord:customer andCommit:YES];
+        };
+
+        beforeEach(^{
+            manager.enableGroupCommit = YES;
+            manager.groupCommitInterval = 60;
+            [manager startCoreDataWithManagedObjectModel:JPDBTestModel()];
+
+            customers = [manager getDatabaseActionForEntity:__customerEntity];
+        });
+
+        afterEach(^{
+            manager.enableGroupCommit = NO;
+        });
+
+        it(@"Should save when the threshold is reached", ^{
+            manager.groupCommitThreshold = 3;
+
+            write();
+            write();
+            [[theValue(manager.groupCommits) should] equal:theValue(0)];
+
+            write();
+            [[theValue(manager.groupCommits) should] equal:theValue(1)];
+            [[theValue(manager.lastGroupCommitWrites) should] equal:theValue(3)];
+        });
+
+        it(@"Should save when the interval is over", ^{
+            manager.groupCommitInterval = 0.1;
+
+            write();
+            write();
+
+            [[expectFutureValue(theValue(manager.groupCommits)) shouldEventually] equal:theValue(1)];
+            [[theValue(manager.groupCommitWrites) should] equal:theValue(2)];
+        });
+
+        it(@"Should save the pending writes on flush", ^{
+            write();
+            [manager flush];
+
+            [[theValue(manager.groupCommits) should] equal:theValue(1)];
+            [[theValue([manager.managedObjectContext hasChanges]) should] beNo];
+        });
+
+        it(@"Should count the pending writes saved by one explicit commit", ^{
+            manager.groupCommitThreshold = 3;
+
+            write();
+            write();
+            [manager commit];
+            [[theValue(manager.groupCommitWrites) should] equal:theValue(2)];
+
+            // Counting starts again.
+            write();
+            write();
+            [[theValue(manager.groupCommits) should] equal:theValue(1)];
+        });
+
+    });
+
+    ////////// ///////// ///////// ///////// ///////// ///////// ///////// ///////// ///////// /////////
+
+    context(@"Identity Map", ^{
+
+        __block NSManagedObject *customer;
+        __block JPDBManagerAction *customers;
+
+        beforeEach(^{
+            [manager startCoreDataWithManagedObjectModel:JPDBTestModel()];
+
+            customer = JPDBTestInsert(manager, __customerEntity, @{@"name" : @"Ann"});
+            [manager commitAndWait];
+
+            customers = [manager getDatabaseActionForEntity:__customerEntity];
+        });
+
+        it(@"Should find the records registered on the context without querying", ^{
+            [[manager shouldNot] receive:@selector(performDatabaseAction:)];
+
+            [[[customers queryRecordWithKey:@"name" value:@"Ann"] should] beIdenticalTo:customer];
+            [[[customers queryRecordWithKey:@"name" value:@"Ann"] should] beIdenticalTo:customer];
+        });
+
+        it(@"Should query the records that aren't registered", ^{
+            [manager.managedObjectContext reset];
+
+            NSManagedObject *found = [customers queryRecordWithKey:@"name" value:@"Ann"];
+            [[[found valueForKey:@"name"] should] equal:@"Ann"];
+            [[[customers queryRecordWithKey:@"name" value:@"Bob"] should] beNil];
+        });
+
+        it(@"Should find the records by his current values", ^{
+            [[[customers queryRecordWithKey:@"name" value:@"Ann"] should] beIdenticalTo:customer];
+
+            [customer setValue:@"Bob" forKey:@"name"];
+
+            [[manager shouldNot] receive:@selector(performDatabaseAction:)];
+            [[[customers queryRecordWithKey:@"name" value:@"Bob"] should] beIdenticalTo:customer];
+        });
+
+        it(@"Should index the records inserted and fetched later, without scanning the context", ^{
+            [[[customers queryRecordWithKey:@"name" value:@"Ann"] should] beIdenticalTo:customer];
+            NSManagedObject *bob = JPDBTestInsert(manager, __customerEntity, @{@"name" : @"Bob"});
+
+            [[manager.managedObjectContext shouldNot] receive:@selector(registeredObjects)];
+            [[manager shouldNot] receive:@selector(performDatabaseAction:)];
+            [[[customers queryRecordWithKey:@"name" value:@"Bob"] should] beIdenticalTo:bob];
+        });
+
+        it(@"Should not return deleted records", ^{
+            [[[customers queryRecordWithKey:@"name" value:@"Ann"] should] beIdenticalTo:customer];
+
+            [customers deleteRecord:customer];
+            [manager commitAndWait];
+
+            [[[customers queryRecordWithKey:@"name" value:@"Ann"] should] beNil];
+        });
+
+    });
+
+    ////////// ///////// ///////// ///////// ///////// ///////// ///////// ///////// ///////// /////////
+
+    context(@"Transactions", ^{
+
+        NSNumber *(^countOf)(NSString *) = ^NSNumber *(NSString *entityName) {
+            return @([[manager getDatabaseActionForEntity:entityName] countRecords]);
+        };
+
+        beforeEach(^{
+            [manager startCoreDataWithManagedObjectModel:JPDBTestModel()];
+        });
+
+        it(@"Should commit once when the block finishes", ^{
+            __block BOOL changesInside = NO;
+
+            BOOL success = [manager performTransaction:^BOOL(NSError **error) {
+                JPDBTestInsert(manager, __customerEntity, @{@"name" : @"Ann"});
+                [manager commit];
+                changesInside = [manager.managedObjectContext hasChanges];
+                return YES;
+            }];
+
+            [[theValue(success) should] beYes];
+            [[theValue(changesInside) should] beYes];
+            [[theValue([manager.managedObjectContext hasChanges]) should] beNo];
+            [[countOf(__customerEntity) should] equal:@1];
+        });
+
+        it(@"Should roll back when the block returns NO", ^{
+            BOOL success = [manager performTransaction:^BOOL(NSError **error) {
+                JPDBTestInsert(manager, __customerEntity, @{@"name" : @"Ann"});
+                return NO;
+            }];
+
+            [[theValue(success) should] beNo];
+            [[theValue([manager.managedObjectContext hasChanges]) should] beNo];
+            [[countOf(__customerEntity) should] equal:@0];
+        });
+
+        it(@"Should roll back only the nested transaction that failed", ^{
+            [manager performTransaction:^BOOL(NSError **error) {
+                JPDBTestInsert(manager, __customerEntity, @{@"name" : @"Ann"});
+
+                [manager performTransaction:^BOOL(NSError **nestedError) {
+                    JPDBTestInsert(manager, __customerEntity, @{@"name" : @"Bob"});
+                    return NO;
+                }];
+
+                [[theValue(manager.inTransaction) should] beYes];
+                return YES;
+            }];
+
+            NSArray *customers = [[manager getDatabaseActionForEntity:__customerEntity] run];
+            [[[customers valueForKey:@"name"] should] equal:@[@"Ann"]];
+            [[theValue(manager.inTransaction) should] beNo];
+        });
+
+        it(@"Should roll back when the block raises, and raise again", ^{
+            [[theBlock(^{
+                [manager performTransaction:^BOOL(NSError **error) {
+                    JPDBTestInsert(manager, __customerEntity, @{@"name" : @"Ann"});
+                    [NSException raise:NSInternalInconsistencyException format:@"Failed"];
+                    return YES;
+                }];
+            }) should] raiseWithName:NSInternalInconsistencyException];
+
+            [[theValue(manager.inTransaction) should] beNo];
+            [[theValue([manager.managedObjectContext hasChanges]) should] beNo];
+            [[countOf(__customerEntity) should] equal:@0];
+        });
+
+        it(@"Should undo the changes when the commit fails", ^{
+            BOOL success = [manager performTransaction:^BOOL(NSError **error) {
+                JPDBTestInsert(manager, __orderEntity, @{@"number" : @-1});
+                return YES;
+            }];
+
+            [[theValue(success) should] beNo];
+            [[theValue([manager.managedObjectContext hasChanges]) should] beNo];
+            [[countOf(__orderEntity) should] equal:@0];
+        });
+
+        it(@"Should make the commits of other threads wait for the transaction", ^{
+            manager.enableBackgroundCommit = YES;
+            [manager closeCoreData];
+            [manager startCoreDataWithManagedObjectModel:JPDBTestModel()];
+
+            __block BOOL committed = NO;
+            __block BOOL committedInside = NO;
+
+            [manager performTransaction:^BOOL(NSError **error) {
+                JPDBTestInsert(manager, __customerEntity, @{@"name" : @"Ann"});
+
+                dispatch_async(dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^{
+                    [manager commit];
+                    committed = YES;
+                });
+
+                [NSThread sleepForTimeInterval:0.2];
+                committedInside = committed;
+                return YES;
+            }];
+
+            [[theValue(committedInside) should] beNo];
+            [[expectFutureValue(theValue(committed)) shouldEventually] beYes];
+            [[countOf(__customerEntity) should] equal:@1];
+        });
+
+    });
+
+    ////////// ///////// ///////// ///////// ///////// ///////// ///////// ///////// ///////// /////////
+
+    context(@"Fetch Templates", ^{
+
+        beforeEach(^{
+            [manager startCoreDataWithManagedObjectModel:JPDBTestModel()];
+
+            JPDBTestInsert(manager, __customerEntity, @{@"name" : @"Ann"});
+            JPDBTestInsert(manager, __customerEntity, @{@"name" : @"Bob"});
+            [manager commitAndWait];
+        });
+
+        // Query the customers with one name, returning the predicate used.
+        NSPredicate *(^customersNamed)(NSString *) = ^NSPredicate *(NSString *name) {
+            JPDBManagerAction *customers = [manager getDatabaseActionForEntity:__customerEntity];
+            NSArray *result = [customers queryWithFetchTemplate:__customersNamedTemplate andVariables:@{@"NAME" : name}];
+
+            [[result should] haveCountOf:1];
+            [[[result[0] valueForKey:@"name"] should] equal:name];
+            return customers.predicate;
+        };
+
+        it(@"Should read each template from the model only once", ^{
+            [manager clearFetchTemplateCache];
+
+            customersNamed(@"Ann");
+            customersNamed(@"Bob");
+            customersNamed(@"Ann");
+
+            [[theValue(manager.fetchTemplateCacheMisses) should] equal:theValue(1)];
+            [[theValue(manager.fetchTemplateCacheHits) should] equal:theValue(2)];
+        });
+
+        it(@"Should reuse the predicates bound to the same variables", ^{
+            NSPredicate *ann = customersNamed(@"Ann");
+
+            [[customersNamed(@"Ann") should] beIdenticalTo:ann];
+            [[customersNamed(@"Bob") shouldNot] beIdenticalTo:ann];
+        });
+
+        it(@"Should read the templates again when cleared", ^{
+            customersNamed(@"Ann");
+            [manager clearFetchTemplateCache];
+            customersNamed(@"Ann");
+
+            [[theValue(manager.fetchTemplateCacheMisses) should] equal:theValue(1)];
+            [[theValue(manager.fetchTemplateCacheHits) should] equal:theValue(0)];
+        });
+
+    });
+
+    ////////// ///////// ///////// ///////// ///////// ///////// ///////// ///////// ///////// /////////
+
+    context(@"Query Cache", ^{
+
+        __block NSManagedObject *customer;
+
+        // Orders of the customers with one name.
+        NSArray *(^ordersOf)(NSString *) = ^NSArray *(NSString *name) {
+            JPDBManagerAction *orders = [manager getDatabaseActionForEntity:__orderEntity];
+            return [orders queryWithPredicate:[NSPredicate predicateWithFormat:@"customer.name == %@", name]];
+        };
+
+        beforeEach(^{
+            manager.enableQueryCache = YES;
+            [manager startCoreDataWithManagedObjectModel:JPDBTestModel()];
+
+            customer = JPDBTestInsert(manager, __customerEntity, @{@"name" : @"Ann"});
+            [JPDBTestInsert(manager, __orderEntity, @{@"number" : @1}) setValue:customer forKey:@"customer"];
+            [manager commitAndWait];
+        });
+
+        it(@"Should answer repeated queries", ^{
+            [[ordersOf(@"Ann") should] haveCountOf:1];
+            [[ordersOf(@"Ann") should] haveCountOf:1];
+
+            [[theValue(manager.queryCache.misses) should] equal:theValue(1)];
+            [[theValue(manager.queryCache.hits) should] equal:theValue(1)];
+        });
+
+        it(@"Should invalidate queries following one relationship of the changed Entity", ^{
+            [[ordersOf(@"Ann") should] haveCountOf:1];
+
+            [customer setValue:@"Bob" forKey:@"name"];
+            [manager commitAndWait];
+
+            [[ordersOf(@"Ann") should] beEmpty];
+            [[ordersOf(@"Bob") should] haveCountOf:1];
+            [[theValue(manager.queryCache.hits) should] equal:theValue(0)];
+        });
+
+        it(@"Should invalidate queries of the changed Entity", ^{
+            [[ordersOf(@"Ann") should] haveCountOf:1];
+
+            [[manager getDatabaseActionForEntity:__orderEntity] deleteAllRecords];
+            [manager commitAndWait];
+
+            [[ordersOf(@"Ann") should] beEmpty];
+        });
+
+        it(@"Should return full objects from the cache", ^{
+            [[ordersOf(@"Ann") should] haveCountOf:1];
+            [manager.managedObjectContext reset];
+
+            NSArray *cached = ordersOf(@"Ann");
+
+            [[theValue(manager.queryCache.hits) should] equal:theValue(1)];
+            [[cached should] haveCountOf:1];
+            [[theValue([cached[0] isFault]) should] beNo];
+        });
+
+        it(@"Should neither cache nor count the queries it can't follow", ^{
+            JPDBManagerAction *customers = [manager getDatabaseActionForEntity:__customerEntity];
+            NSPredicate *predicate = [NSPredicate predicateWithFormat:@"SUBQUERY(orders, $order, $order.number > 0).@count > 0"];
+
+            [[[customers queryWithPredicate:predicate] should] haveCountOf:1];
+            [[[customers queryWithPredicate:predicate] should] haveCountOf:1];
+
+            [[theValue(manager.queryCache.hits) should] equal:theValue(0)];
+            [[theValue(manager.queryCache.misses) should] equal:theValue(0)];
+        });
+
+    });
+
+    ////////// ///////// ///////// ///////// ///////// ///////// ///////// ///////// ///////// /////////
+
+    context(@"Metrics", ^{
+
+        __block JPDBManagerMetrics *metrics;
+
+        NSDictionary *(^query)(NSString *, NSTimeInterval, NSUInteger) = ^NSDictionary *(NSString *entity, NSTimeInterval duration, NSUInteger rows) {
+            return @{JPDBManagerMetricEntity : entity, JPDBManagerMetricDuration : @(duration), JPDBManagerMetricRows : @(rows)};
+        };
+
+        beforeEach(^{
+            metrics = [JPDBManagerMetrics new];
+        });
+
+        it(@"Should keep one latency histogram per Entity", ^{
+            [metrics recordQuery:query(__customerEntity, 0.0005, 1)];
+            [metrics recordQuery:query(__customerEntity, 0.003, 2)];
+            [metrics recordQuery:query(__customerEntity, 2.0, 3)];
+            [metrics recordQuery:query(__orderEntity, 0.0005, 1)];
+
+            NSDictionary *customers = [metrics snapshot][@"entities"][__customerEntity];
+            NSArray *histogram = customers[@"histogram"];
+
+            [[histogram should] haveCountOf:[[JPDBManagerMetrics histogramBounds] count] + 1];
+            [[histogram[0] should] equal:@1];
+            [[histogram[2] should] equal:@1];
+            [[[histogram lastObject] should] equal:@1];
+
+            [[customers[@"count"] should] equal:@3];
+            [[customers[@"rows"] should] equal:@6];
+            [[customers[@"maxTime"] should] equal:@2.0];
+            [[[metrics snapshot][@"entities"][__orderEntity][@"count"] should] equal:@1];
+        });
+
+        it(@"Should keep only the last slow queries", ^{
+            metrics.slowQueryThreshold = 0.1;
+            metrics.slowQueryLogLimit = 2;
+
+            [metrics recordQuery:query(__customerEntity, 0.2, 0)];
+            [metrics recordQuery:query(__customerEntity, 0.01, 0)];
+            [metrics recordQuery:query(__customerEntity, 0.3, 0)];
+            [metrics recordQuery:query(__customerEntity, 0.4, 0)];
+
+            NSArray *slowQueries = [metrics snapshot][@"slowQueries"];
+            [[[slowQueries valueForKey:JPDBManagerMetricDuration] should] equal:@[@0.3, @0.4]];
+        });
+
+        it(@"Should total the commits", ^{
+            [metrics recordCommit:@{JPDBManagerMetricDuration : @0.01, JPDBManagerMetricInserted : @2, JPDBManagerMetricDeleted : @1}];
+            [metrics recordCommit:@{JPDBManagerMetricDuration : @0.01, JPDBManagerMetricUpdated : @3}];
+
+            NSDictionary *commits = [metrics snapshot][@"commits"];
+            [[commits[@"count"] should] equal:@2];
+            [[commits[JPDBManagerMetricInserted] should] equal:@2];
+            [[commits[JPDBManagerMetricUpdated] should] equal:@3];
+            [[commits[JPDBManagerMetricDeleted] should] equal:@1];
+        });
+
+        it(@"Should return snapshots that don't change", ^{
+            [metrics recordQuery:query(__customerEntity, 0.001, 1)];
+            NSDictionary *snapshot = [metrics snapshot];
+
+            [metrics recordQuery:query(__customerEntity, 0.001, 1)];
+            [metrics reset];
+
+            [[snapshot[@"entities"][__customerEntity][@"count"] should] equal:@1];
+            [[[metrics snapshot][@"entities"] should] beEmpty];
+        });
+
+        it(@"Should record the queries and commits of the manager", ^{
+            manager.enableMetrics = YES;
+            [manager startCoreDataWithManagedObjectModel:JPDBTestModel()];
+
+            JPDBTestInsert(manager, __customerEntity, @{@"name" : @"Ann"});
+            [manager commitAndWait];
+            [[manager getDatabaseActionForEntity:__customerEntity] run];
+
+            NSDictionary *snapshot = [manager.metrics snapshot];
+            [[snapshot[@"entities"][__customerEntity][@"count"] should] beGreaterThanOrEqualTo:@1];
+            [[snapshot[@"commits"][JPDBManagerMetricInserted] should] equal:@1];
+        });
+
+    });
+
+    ////////// ///////// ///////// ///////// ///////// ///////// ///////// ///////// ///////// /////////
+
+    context(@"Memory Governor", ^{
+
+        __block NSManagedObjectContext *context;
+        __block JPDBManagerMemoryGovernor *governor;
+        __block NSArray *customers;
+
+        beforeEach(^{
+            [manager startCoreDataWithManagedObjectModel:JPDBTestModel()];
+            context = manager.managedObjectContext;
+
+            for (NSString *name in @[@"Ann", @"Bob", @"Carl", @"Dora"])
+                JPDBTestInsert(manager, __customerEntity, @{@"name" : name});
+            JPDBTestInsert(manager, __eventEntity, @{@"name" : @"launch"});
+            [manager commitAndWait];
+
+            customers = [[manager getDatabaseActionForEntity:__customerEntity] run];
+            governor = [JPDBManagerMemoryGovernor initWithContext:context];
+        });
+
+        it(@"Should count the registered objects of each Entity", ^{
+            NSDictionary *statistics = [governor statistics];
+
+            [[statistics[JPDBManagerMemoryObjects] should] equal:@5];
+            [[statistics[JPDBManagerMemoryFaults] should] equal:@0];
+            [[statistics[JPDBManagerMemoryEntities][__customerEntity][JPDBManagerMemoryObjects] should] equal:@4];
+            [[statistics[JPDBManagerMemoryEntities][__eventEntity][JPDBManagerMemoryObjects] should] equal:@1];
+        });
+
+        it(@"Should turn clean objects into faults and keep the changed ones", ^{
+            NSManagedObject *changed = customers[0];
+            [changed setValue:@"Anna" forKey:@"name"];
+
+            NSDictionary *collection = [governor collect];
+
+            [[collection[JPDBManagerMemoryReset] should] equal:@NO];
+            [[theValue([changed isFault]) should] beNo];
+            [[theValue([customers[1] isFault]) should] beYes];
+            [[collection[JPDBManagerMemoryAfter][JPDBManagerMemoryFaults] should] equal:@4];
+            [[theValue(governor.collections) should] equal:theValue(1)];
+        });
+
+        it(@"Should only collect when the limits are crossed", ^{
+            [[governor collectIfNeeded] shouldBeNil];
+
+            governor.objectsLimit = 2;
+            [[governor collectIfNeeded] shouldNotBeNil];
+            [governor.lastCollection shouldNotBeNil];
+        });
+
+        it(@"Should keep the spared objects", ^{
+            governor.objectsLimit = 2;
+            governor.resetContext = YES;
+
+            NSDictionary *collection = [governor collectIfNeededSparing:customers];
+
+            [[collection[JPDBManagerMemoryReset] should] equal:@NO];
+            for (NSManagedObject *customer in customers)
+                [[theValue([customer isFault]) should] beNo];
+        });
+
+        it(@"Should reset the context when nothing is spared or changed", ^{
+            governor.objectsLimit = 2;
+            governor.resetContext = YES;
+
+            NSDictionary *collection = [governor collectIfNeeded];
+
+            [[collection[JPDBManagerMemoryReset] should] equal:@YES];
+            [[[context registeredObjects] should] beEmpty];
+        });
+
+        it(@"Should ask for one check after one tenth of the limit", ^{
+            governor.objectsLimit = 100;
+
+            [[theValue([governor noteRegisteredObjects:9]) should] beNo];
+            [[theValue([governor noteRegisteredObjects:1]) should] beYes];
+            [[theValue([governor noteRegisteredObjects:1]) should] beNo];
+        });
+
+        it(@"Should collect after the records of one query were returned", ^{
+            manager.enableMemoryGovernor = YES;
+            manager.memoryGovernor.objectsLimit = 2;
+            manager.memoryGovernor.resetContext = YES;
+
+            NSArray *records = [[manager getDatabaseActionForEntity:__customerEntity] run];
+
+            // Still usable, nothing was collected yet.
+            [[theValue(manager.memoryGovernor.collections) should] equal:theValue(0)];
+            for (NSManagedObject *record in records)
+                [[theValue([record isFault]) should] beNo];
+
+            [[expectFutureValue(theValue(manager.memoryGovernor.collections)) shouldEventually] equal:theValue(1)];
+            [[manager.memoryGovernor.lastCollection[JPDBManagerMemoryReset] should] equal:@NO];
+            for (NSManagedObject *record in records)
+                [[theValue([record isFault]) should] beNo];
+        });
+
+    });
+
+    ////////// ///////// ///////// ///////// ///////// ///////// ///////// ///////// ///////// /////////
+
+    context(@"Change Feed", ^{
+
+        __block NSArray *delivered;
+
+        beforeEach(^{
+            delivered = nil;
+            manager.enableChangeFeed = YES;
+        });
+
+        // Entity names of the changes delivered.
+        NSArray *(^deliveredEntities)(void) = ^NSArray *{
+            return [[delivered valueForKey:@"entityName"] sortedArrayUsingSelector:@selector(compare:)];
+        };
+
+        it(@"Should subscribe without starting the Core Data", ^{
+            [manager.changeFeed subscribeToEntities:nil keys:nil queue:nil block:^(NSArray *changes) {
+                delivered = changes;
+            }];
+            [[theValue(manager.isReady) should] beNo];
+
+            [manager startCoreDataWithManagedObjectModel:JPDBTestModel()];
+            JPDBTestInsert(manager, __customerEntity, @{@"name" : @"Ann"});
+            [manager commitAndWait];
+
+            [[expectFutureValue(delivered) shouldEventually] haveCountOf:1];
+            [[[delivered[0] insertedObjectIDs] should] haveCountOf:1];
+        });
+
+        it(@"Should keep the subscriptions when the Core Data starts again", ^{
+            [manager startCoreDataWithManagedObjectModel:JPDBTestModel()];
+            [manager.changeFeed subscribeToEntities:nil keys:nil queue:nil block:^(NSArray *changes) {
+                delivered = changes;
+            }];
+
+            [manager closeCoreData];
+            [manager startCoreDataWithManagedObjectModel:JPDBTestModel()];
+            JPDBTestInsert(manager, __eventEntity, @{@"name" : @"launch"});
+            [manager commitAndWait];
+
+            [[expectFutureValue(delivered) shouldEventually] haveCountOf:1];
+            [[deliveredEntities() should] equal:@[__eventEntity]];
+        });
+
+        it(@"Should deliver only the subscribed Entities", ^{
+            [manager startCoreDataWithManagedObjectModel:JPDBTestModel()];
+            [manager.changeFeed subscribeToEntities:@[__orderEntity] keys:nil queue:nil block:^(NSArray *changes) {
+                delivered = changes;
+            }];
+
+            NSManagedObject *customer = JPDBTestInsert(manager, __customerEntity, @{@"name" : @"Ann"});
+            [JPDBTestInsert(manager, __orderEntity, @{@"number" : @1}) setValue:customer forKey:@"customer"];
+            [manager commitAndWait];
+
+            [[expectFutureValue(delivered) shouldEventually] haveCountOf:1];
+            [[deliveredEntities() should] equal:@[__orderEntity]];
+        });
+
+        it(@"Should deliver only the updates of the subscribed keys", ^{
+            [manager startCoreDataWithManagedObjectModel:JPDBTestModel()];
+            NSManagedObject *customer = JPDBTestInsert(manager, __customerEntity, @{@"name" : @"Ann"});
+            [manager commitAndWait];
+
+            [manager.changeFeed subscribeToEntities:@[__customerEntity] keys:@[@"name"] queue:nil block:^(NSArray *changes) {
+                delivered = changes;
+            }];
+
+            // Only the orders of the customer change.
+            [JPDBTestInsert(manager, __orderEntity, @{@"number" : @1}) setValue:customer forKey:@"customer"];
+            [manager commitAndWait];
+            [[expectFutureValue(delivered) shouldAfterWaitOf(0.5)] beNil];
+
+            [customer setValue:@"Anna" forKey:@"name"];
+            [manager commitAndWait];
+
+            [[expectFutureValue(delivered) shouldEventually] haveCountOf:1];
+            [[[delivered[0] changedKeys] should] equal:[NSSet setWithObject:@"name"]];
+            [[[delivered[0] changedKeysOfObjectID:customer.objectID] should] equal:[NSSet setWithObject:@"name"]];
+        });
+
+        it(@"Should deliver on the queue of the subscription", ^{
+            static char queueKey;
+            __block BOOL onQueue = NO;
+
+            dispatch_queue_t queue = dispatch_queue_create("org.seqoy.jump.tests.feed", DISPATCH_QUEUE_SERIAL);
+            dispatch_queue_set_specific(queue, &queueKey, &queueKey, NULL);
+
+            [manager startCoreDataWithManagedObjectModel:JPDBTestModel()];
+            [manager.changeFeed subscribeToEntities:nil keys:nil queue:queue block:^(NSArray *changes) {
+                onQueue = dispatch_get_specific(&queueKey) == &queueKey;
+                delivered = changes;
+            }];
+
+            JPDBTestInsert(manager, __eventEntity, @{@"name" : @"launch"});
+            [manager commitAndWait];
+
+            [[expectFutureValue(delivered) shouldEventually] haveCountOf:1];
+            [[theValue(onQueue) should] beYes];
+        });
+
+    });
+
+    ////////// ///////// ///////// ///////// ///////// ///////// ///////// ///////// ///////// /////////
+
+    context(@"Partitions", ^{
+
+        beforeEach(^{
+            JPDBManagerStoreConfiguration *inMemory = [JPDBManagerStoreConfiguration configurationNamed:JPDBManagerStoreProfileInMemory];
+            [manager addPartition:@"telemetry" entities:@[__eventEntity] configuration:inMemory];
+            [manager addPartition:@"sales" entities:@[__customerEntity, __orderEntity] configuration:inMemory];
+            [manager startCoreDataWithManagedObjectModel:JPDBTestModel()];
+        });
+
+        it(@"Should open one store per partition", ^{
+            [[[manager partitions] should] equal:@[@"sales", @"telemetry"]];
+
+            NSPersistentStore *telemetry = [manager persistentStoreOfPartition:@"telemetry"];
+            NSPersistentStore *sales = [manager persistentStoreOfPartition:@"sales"];
+
+            [telemetry shouldNotBeNil];
+            [sales shouldNotBeNil];
+            [[telemetry shouldNot] equal:sales];
+
+            [[[manager persistentStoreForEntity:__eventEntity] should] equal:telemetry];
+            [[[manager persistentStoreForEntity:__orderEntity] should] equal:sales];
+        });
+
+        it(@"Should save new records on the store of his partition", ^{
+            NSManagedObject *event = JPDBTestInsert(manager, __eventEntity, @{@"name" : @"launch"});
+            NSManagedObject *customer = JPDBTestInsert(manager, __customerEntity, @{@"name" : @"Ann"});
+            [manager commitAndWait];
+
+            [[event.objectID.persistentStore should] equal:[manager persistentStoreOfPartition:@"telemetry"]];
+            [[customer.objectID.persistentStore should] equal:[manager persistentStoreOfPartition:@"sales"]];
+
+            JPDBManagerAction *events = [manager getDatabaseActionForEntity:__eventEntity];
+            [[events.affectedStores should] equal:@[[manager persistentStoreOfPartition:@"telemetry"]]];
+            [[[events run] should] haveCountOf:1];
+        });
+
+        it(@"Should drop only the records of one partition", ^{
+            JPDBTestInsert(manager, __eventEntity, @{@"name" : @"launch"});
+            JPDBTestInsert(manager, __customerEntity, @{@"name" : @"Ann"});
+            [manager commitAndWait];
+
+            [[theValue([manager resetPartition:@"telemetry" error:NULL]) should] beYes];
+
+            [[@([[manager getDatabaseActionForEntity:__eventEntity] countRecords]) should] equal:@0];
+            [[@([[manager getDatabaseActionForEntity:__customerEntity] countRecords]) should] equal:@1];
+        });
+
+        it(@"Should refuse new partitions after the start", ^{
+            [[theBlock(^{
+                [manager addPartition:@"late" entities:@[__eventEntity] configuration:nil];
+            }) should] raiseWithName:JPDBManagerStartException];
+        });
+
+    });
+
+    ////////// ///////// ///////// ///////// ///////// ///////// ///////// ///////// ///////// /////////
+
+    context(@"Import", ^{
+
+        __block JPDBManagerAction *orders;
+
+        beforeEach(^{
+            [manager startCoreDataWithManagedObjectModel:JPDBTestModel()];
+            orders = [manager getDatabaseActionForEntity:__orderEntity];
+        });
+
+        it(@"Should commit only the imported records", ^{
+            NSManagedObject *customer = JPDBTestInsert(manager, __customerEntity, @{@"name" : @"Ann"});
+
+            [[theValue([orders importRecords:@[@{@"number" : @1}, @{@"number" : @"2"}]]) should] equal:theValue(2)];
+
+            // The pending customer stays on the main context.
+            [[theValue(customer.objectID.isTemporaryID) should] beYes];
+            [[expectFutureValue(@([[manager getDatabaseActionForEntity:__orderEntity] countRecords])) shouldEventually] equal:@2];
+        });
+
+        it(@"Should keep the committed batches when one record isn't a dictionary", ^{
+            [[theBlock(^{
+                [orders importRecords:@[@{@"number" : @1}, @"not a record"] inBatchesOfSize:1 progress:nil];
+            }) should] raiseWithName:JPDBManagerActionException];
+
+            [[expectFutureValue(@([[manager getDatabaseActionForEntity:__orderEntity] countRecords])) shouldEventually] equal:@1];
+        });
+
+    });
+
+    ////////// ///////// ///////// ///////// ///////// ///////// ///////// ///////// ///////// /////////
+
+    context(@"Batch Delete", ^{
+
+        beforeEach(^{
+            [manager startCoreDataWithManagedObjectModel:JPDBTestModel()];
+        });
+
+        it(@"Should commit only the deleted records", ^{
+            JPDBTestInsert(manager, __eventEntity, @{@"name" : @"launch"});
+            JPDBTestInsert(manager, __eventEntity, @{@"name" : @"resume"});
+            [manager commitAndWait];
+
+            NSManagedObject *customer = JPDBTestInsert(manager, __customerEntity, @{@"name" : @"Ann"});
+
+            [[theValue([[manager getDatabaseActionForEntity:__eventEntity] deleteAllRecords]) should] equal:theValue(2)];
+
+            // The pending customer stays on the main context.
+            [[theValue(customer.objectID.isTemporaryID) should] beYes];
+            [[expectFutureValue(@([[manager getDatabaseActionForEntity:__eventEntity] countRecords])) shouldEventually] equal:@0];
+        });
+
+    });
+
+});
+
+SPEC_END
@@ -3,6 +3,7 @@
 #import "Kiwi.h"
 #import "JPDBManagerSingleton.h"
 #import "NSManagedObject+JPDatabase.h"
+#import "JPDBManagerPredicateCache.h"
 
 // Fake object.
 @interface Entity : NSManagedObject
@@ -80,8 +81,9 @@ describe(@"Managed Object", ^{
 
         it(@"Should count how many object this entity has", ^{
 
-            // Manager return 2 objects.
-            [mockedManager stub:@selector(performDatabaseAction:) andReturn:@[any(), any()] withArguments:any()];
+            // Manager count 2 objects, without fetching them.
+            [mockedManager stub:@selector(countWithAction:) andReturn:@2 withArguments:any()];
+            [[mockedManager shouldNot] receive:@selector(performDatabaseAction:)];
 
             [[@([Entity count]) should] equal:@2];
         });
@@ -91,14 +93,14 @@ describe(@"Managed Object", ^{
         it(@"Should count with specific query", ^{
             NSString *predicate = @"predicate == test";
 
-            [mockedManager stub:@selector(performDatabaseAction:)
+            [mockedManager stub:@selector(countWithAction:)
 
                withBlock:^id(NSArray *params) {
                    JPDBManagerAction *action = params[0];
                    [[[action predicate].predicateFormat should] equal:predicate];
 
-                   // Return 4 objects.
-                   return @[any(), any(), any(), any()];
+                   // Count 4 objects.
+                   return @4;
                }
             ];
             
@@ -106,6 +108,25 @@ describe(@"Managed Object", ^{
             [[@([Entity countWhere:predicate]) should] equal:@4];
         });
 
+
+
+        it(@"Should count distinct values of an attribute", ^{
+            [mockedManager stub:@selector(performDatabaseAction:)
+
+                      withBlock:^id(NSArray *params) {
+                          JPDBManagerAction *action = params[0];
+                          [[@(action.resultType) should] equal:@(NSDictionaryResultType)];
+                          [[@(action.returnsDistinctResults) should] beTrue];
+                          [[action.propertiesToFetch should] equal:@[@"_key_"]];
+
+                          // Return 3 distinct values.
+                          return @[@{@"_key_" : @1}, @{@"_key_" : @2}, @{@"_key_" : @3}];
+                      }
+            ];
+
+            [[@([Entity countDistinct:@"_key_"]) should] equal:@3];
+        });
+
     });
 
     /////////////// ///////////////// ///////////////// ///////////////// ///////////////// ///////////////// /////////
@@ -233,6 +254,35 @@ describe(@"Managed Object", ^{
 
 
 
+        it(@"Should parse one query only once and bind his parameters", ^{
+            NSString *query = @"format == %@ AND other == %@";
+            JPDBManagerPredicateCache *cache = [JPDBManagerPredicateCache sharedCache];
+            [cache removeAllPredicates];
+
+            __block NSString *where;
+            [mockedManager stub:@selector(performDatabaseAction:)
+
+                      withBlock:^id(NSArray *params) {
+                          JPDBManagerAction *action = params[0];
+                          where = [action predicate].predicateFormat;
+                          return @[];
+                      }
+            ];
+
+            [Entity where:query, @"first", @1];
+            [[where should] equal:@"format == \"first\" AND other == 1"];
+
+            [Entity where:query, @"second", @2];
+            [[where should] equal:@"format == \"second\" AND other == 2"];
+
+            [[theValue(cache.misses) should] equal:theValue(1)];
+            [[theValue(cache.hits) should] equal:theValue(1)];
+
+        });
+
+
+
+
         it(@"Should find this Entity using one specific query", ^{
             NSString *predicate = @"id == 1";
             Entity *object      = [Entity new];
@@ -243,6 +293,7 @@ describe(@"Managed Object", ^{
                           JPDBManagerAction *action = params[0];
 
                           [[[action predicate].predicateFormat should] equal:predicate];
+                          [[theValue(action.fetchLimit) should] equal:theValue(1)];
 
                           // Return 1 object.
                           return @[object];
@@ -258,6 +309,25 @@ describe(@"Managed Object", ^{
 
 
 
+        it(@"Should find this Entity by one key using the in-memory index", ^{
+            id object = [KWMock mockForClass:[Entity class]];
+            [object stub:@selector(isDeleted) andReturn:theValue(NO)];
+            [object stub:@selector(managedObjectContext) andReturn:any()];
+            [object stub:@selector(valueForKey:) andReturn:@"john@example.com" withArguments:@"email"];
+
+            [mockedManager stub:@selector(identityMapForKey:ofAction:) andReturn:[NSMapTable strongToWeakObjectsMapTable]];
+
+            // Only the first lookup goes to the store.
+            [[mockedManager should] receive:@selector(performDatabaseAction:) andReturn:@[object] withCount:1];
+
+            [[[Entity findByKey:@"email" value:@"john@example.com"] should] equal:object];
+            [[[Entity findByKey:@"email" value:@"john@example.com"] should] equal:object];
+
+        });
+
+
+
+
         it(@"Should query using block", ^{
             NSString *predicate = @"predicate == test";
 
@@ -299,18 +369,18 @@ describe(@"Managed Object", ^{
 
         it (@"Should delete all objects of this entity", ^{
 
-            // Data object to delete.
-            Entity * dataObject = [Entity new];
+            // Object IDs to delete.
+            NSArray *objectIDs = @[any(), any()];
 
-            // Mock manager to return this data object to delete.
-            [mockedManager stub:@selector(performDatabaseAction:) andReturn:@[dataObject, dataObject]];
+            // Mock manager to return the Object IDs to delete.
+            [mockedManager stub:@selector(performDatabaseAction:) andReturn:objectIDs];
 
-            // Mock manager to delete this object.
-            [mockedManager stub:@selector(deleteRecord:) withArguments:dataObject];
-            [[mockedManager should] receive:@selector(deleteRecord:) withCount:2 arguments:dataObject];
+            // Mock manager to delete them, in one batch.
+            [mockedManager stub:@selector(deleteRecordsWithIDs:fromAction:)];
+            [[mockedManager should] receive:@selector(deleteRecordsWithIDs:fromAction:) withCount:1 arguments:objectIDs, any()];
 
             // Test it.
-            [Entity deleteAll];
+            [[@([Entity deleteAll]) should] equal:@2];
 
         });
     });
@@ -0,0 +1,11 @@
+#!/bin/sh
+# Run the database benchmarks and compare with the baselines. Pass --update to record the results as the new baseline.
+# Until the first baseline is recorded the results are only reported.
+export JPDB_BENCHMARK=1
+export JPDB_BENCHMARK_OUTPUT=${JPDB_BENCHMARK_OUTPUT:-$PWD/Benchmarks/results.json}
+
+# Simulator processes receive the variables prefixed.
+export SIMCTL_CHILD_JPDB_BENCHMARK=$JPDB_BENCHMARK SIMCTL_CHILD_JPDB_BENCHMARK_OUTPUT=$JPDB_BENCHMARK_OUTPUT SIMCTL_CHILD_JPDB_BENCHMARK_SIZES=$JPDB_BENCHMARK_SIZES
+
+xctool -workspace Example.xcworkspace -scheme Example -sdk iphonesimulator test -only ExampleTests:DatabaseBenchmarks \
+    && ruby Benchmarks/checkBenchmarks.rb "$JPDB_BENCHMARK_OUTPUT" Benchmarks/baseline.json $1
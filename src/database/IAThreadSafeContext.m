@@ -88,27 +88,18 @@
     [self runInvocationOnContextThread:call];
 }
 
-- (void*) runInvocation:(NSInvocation*) call {
-    //returns primitive types only
-    void* lastResult = NULL;
+- (NSUInteger) runInvocation:(NSInvocation*) call {
+    //returns primitive types only, up to the size of an NSUInteger (BOOL, NSUInteger)
+    NSUInteger result = 0;
     NSUInteger length = [[call methodSignature] methodReturnLength];
     
-    if (length > 0) {
-        //only malloc if we have a non-zero size
-        lastResult = (void*)malloc(length);
-    }
     [self runInvocationOnContextThread:call];
-    if (length <= 0) {
-        //if there's nothing to return, just return NULL
-        return NULL;
-    }
-    
     
-    [call getReturnValue:lastResult];
+    //copy off the value itself, the next operation on this context will overwrite it
+    if (length > 0 && length <= sizeof(result)) {
+        [call getReturnValue:&result];
+    }
     
-    //now copy off the result (the next operation on this context will overwrite it)
-    void* result = lastResult;
-    free((void*)lastResult);
     return result;
 }
 
@@ -56,4 +56,11 @@
     NSThread* myThread;
 }
 
+/**
+ * Run a block on the thread that owns this object, waiting until it finishes.  Every setter called inside the 
+ * block runs directly, so updating many attributes from another thread costs a single thread hop instead of 
+ * one per attribute.  'setValuesForKeysWithDictionary:' is batched the same way.
+ */
+- (void) performBatchUpdates:(void (^)(void))block;
+
 @end
@@ -8,7 +8,8 @@
 #import "IAThreadSafeManagedObject.h"
 #import <objc/runtime.h>
 
-void dynamicSetter(id self, SEL _cmd, id obj);
+//  Set one value on the thread that owns the object.  Called by every generated setter.
+static void IASetValueForKey(IAThreadSafeManagedObject* self, NSString* key, id value);
 
 @implementation IAThreadSafeManagedObject
 
@@ -42,57 +43,102 @@ void dynamicSetter(id self, SEL _cmd, id obj);
     return myThread;
 }
 
-- (void) recallDynamicSetter:(SEL)sel withObject:(id)obj {
-    dynamicSetter(self, sel, obj);
+- (BOOL) isOnCorrectThread {
+    return ! myThread || [NSThread currentThread] == myThread;
 }
 
-- (void) runInvocationOnCorrectThread:(NSInvocation*)call {
-    if (! [self myThread] || [NSThread currentThread] == [self myThread]) {
+- (void) runBlock:(void (^)(void))block {
+    block();
+}
+
+- (void) runBlockOnCorrectThread:(void (^)(void))block {
+    if ([self isOnCorrectThread]) {
         //okay to invoke
-        [call invoke];
+        block();
     }
     else {
         //remap to the correct thread
-        [self performSelector:@selector(runInvocationOnCorrectThread:) onThread:myThread withObject:call waitUntilDone:YES];
+        [self performSelector:@selector(runBlock:) onThread:myThread withObject:block waitUntilDone:YES];
     }
 }
 
-void dynamicSetter(id self, SEL _cmd, __unsafe_unretained id obj) {
-    if (! [self myThread] || [NSThread currentThread] == [self myThread]) {
+- (void) performBatchUpdates:(void (^)(void))block {
+    [self runBlockOnCorrectThread:block];
+}
+
+- (void) setValuesForKeysWithDictionary:(NSDictionary *)keyedValues {
+    //one thread hop for all the values
+    [self runBlockOnCorrectThread:^{
+        [super setValuesForKeysWithDictionary:keyedValues];
+    }];
+}
+
+static void IASetValueForKey(IAThreadSafeManagedObject* self, NSString* key, id value) {
+    if ([self isOnCorrectThread]) {
         //okay to execute
-        //XXX:  clunky way to get the property name, but meh...
-        NSString* targetSel = NSStringFromSelector(_cmd);
-        NSString* propertyNameUpper = [targetSel substringFromIndex:3];  //remove the 'set'
-        NSString* firstLetter = [[propertyNameUpper substringToIndex:1] lowercaseString];
-        NSString* propertyName = [NSString stringWithFormat:@"%@%@", firstLetter, [propertyNameUpper substringFromIndex:1]];
-        propertyName = [propertyName substringToIndex:[propertyName length] - 1];
-        
-        //NSLog(@"Setting property:  name=%@", propertyName);
-        
-        [self willChangeValueForKey:propertyName];
-        [self setPrimitiveValue:obj forKey:propertyName];
-        [self didChangeValueForKey:propertyName];
-        
+        [self willChangeValueForKey:key];
+        [self setPrimitiveValue:value forKey:key];
+        [self didChangeValueForKey:key];
     }
     else {
         //call back on the correct thread
-        NSMethodSignature* sig = [self methodSignatureForSelector:@selector(recallDynamicSetter:withObject:)];
-        NSInvocation* call = [NSInvocation invocationWithMethodSignature:sig];
-        [call retainArguments];
-        call.target = self;
-        call.selector = @selector(recallDynamicSetter:withObject:);
-        [call setArgument:&_cmd atIndex:2];
-        [call setArgument:&obj atIndex:3];
-        
-        [self runInvocationOnCorrectThread:call];
+        [self runBlockOnCorrectThread:^{
+            IASetValueForKey(self, key, value);
+        }];
+    }
+}
+
+//  'setFooBar:' -> 'fooBar'.  Only computed once per class and selector, when the setter is resolved.
+static NSString* IAPropertyNameOfSetter(SEL sel) {
+    NSString* targetSel = NSStringFromSelector(sel);
+    NSString* propertyNameUpper = [targetSel substringWithRange:NSMakeRange(3, [targetSel length] - 4)];  //remove 'set' and ':'
+    
+    return [[[propertyNameUpper substringToIndex:1] lowercaseString] stringByAppendingString:[propertyNameUpper substringFromIndex:1]];
+}
+
+//  Setter for the declared type of the property, scalar values are boxed as Core Data stores them.
+#define IAScalarSetter(type) imp_implementationWithBlock(^(IAThreadSafeManagedObject* self, type value) { \
+            IASetValueForKey(self, key, @(value)); \
+        })
+
+static IMP IASetterForProperty(Class class, NSString* key, const char** types) {
+    objc_property_t property = class_getProperty(class, [key UTF8String]);
+    const char* attributes = property ? property_getAttributes(property) : NULL;
+    char type = (attributes && attributes[0] == 'T') ? attributes[1] : '@';
+
+    switch (type) {
+        case 'c': *types = "v@:c"; return IAScalarSetter(char);
+        case 'C': *types = "v@:C"; return IAScalarSetter(unsigned char);
+        case 's': *types = "v@:s"; return IAScalarSetter(short);
+        case 'S': *types = "v@:S"; return IAScalarSetter(unsigned short);
+        case 'i': *types = "v@:i"; return IAScalarSetter(int);
+        case 'I': *types = "v@:I"; return IAScalarSetter(unsigned int);
+        case 'l': *types = "v@:l"; return IAScalarSetter(long);
+        case 'L': *types = "v@:L"; return IAScalarSetter(unsigned long);
+        case 'q': *types = "v@:q"; return IAScalarSetter(long long);
+        case 'Q': *types = "v@:Q"; return IAScalarSetter(unsigned long long);
+        case 'f': *types = "v@:f"; return IAScalarSetter(float);
+        case 'd': *types = "v@:d"; return IAScalarSetter(double);
+        case 'B': *types = "v@:B"; return IAScalarSetter(bool);
+        default:
+            *types = "v@:@";
+            return imp_implementationWithBlock(^(IAThreadSafeManagedObject* self, id value) {
+                IASetValueForKey(self, key, value);
+            });
     }
 }
 
 + (BOOL) resolveInstanceMethod:(SEL)sel {
     NSString* targetSel = NSStringFromSelector(sel);
-    if ([targetSel hasPrefix:@"set"] && [targetSel rangeOfString:@"Primitive"].location == NSNotFound) {
-        NSLog(@"Overriding selector:  %@", targetSel);
-        class_addMethod([self class], sel, (IMP)dynamicSetter, "v@:@");
+    if ([targetSel hasPrefix:@"set"] && [targetSel length] > 4 && [targetSel hasSuffix:@":"]
+            && [targetSel rangeOfString:@":"].location == [targetSel length] - 1
+            && [targetSel rangeOfString:@"Primitive"].location == NSNotFound) {
+        
+        //the key is captured by the setter, so nothing is computed again on each set
+        const char* types = NULL;
+        IMP setter = IASetterForProperty(self, IAPropertyNameOfSetter(sel), &types);
+        
+        class_addMethod(self, sel, setter, types);
         return YES;
     }
     
@@ -32,6 +32,13 @@
  * Also consult \ref errors and \ref queries.
  */
 @class JPDBManagerAction;
+@class JPDBManagerMetadata;
+@class JPDBManagerQueryCache;
+@class JPDBManagerMemoryGovernor;
+@class JPDBManagerStoreConfiguration;
+@class JPDBManagerChangeFeed;
+@class JPDBManagerMetrics;
+@protocol JPDBManagerMetricsDelegate;
 
 @interface JPDBManager : NSObject
 
@@ -40,6 +47,24 @@
  */
 @property(readonly) NSManagedObjectModel *managedObjectModel;
 
+/**
+ * Immutable index of the Entities, Attributes and Relationships of the #managedObjectModel.
+ * Built once when the model is loaded, see JPDBManagerMetadata.
+ */
+@property(readonly) JPDBManagerMetadata *metadata;
+
+/**
+ * How many times an Fetch Template predicate was reused from the cache.
+ * Templates are read from the model only once, and the predicates bound to the same <b>fetchVariables</b>
+ * are reused too, up to \ref JPDBManagerDefaultFetchTemplateBindings for each template.
+ */
+@property(readonly) NSUInteger fetchTemplateCacheHits;
+
+/**
+ * How many times an Fetch Template predicate was read from the model.
+ */
+@property(readonly) NSUInteger fetchTemplateCacheMisses;
+
 /**
  * Core Data Managed Object Context
  */
@@ -56,6 +81,31 @@
  */
 @property(readonly) NSString *loadedModelName;
 
+/**
+ * <b>YES</b> when the Persistent Store was opened. Useful with #startCoreDataAsyncWithCompletion:.
+ */
+@property(readonly) BOOL isReady;
+
+/**
+ * <b>YES</b> if the store wasn't compatible with the model when it was opened, so it was migrated.
+ * Only checked by #startCoreDataAsyncWithCompletion:.
+ */
+@property(readonly) BOOL storeRequiredMigration;
+
+/**
+ * Duration in seconds of each phase of the last #startCoreDataAsyncWithCompletion:. Keys are defined on
+ * JPDBManagerDefinitions.h, like \ref JPDBManagerStartupPhaseStoreOpen.
+ */
+@property(readonly) NSDictionary *startupTimings;
+
+/**
+ * How the Persistent Store is opened: store type and location, read-only, SQLite journal mode and pragmas.
+ * Set it before starting the Core Data, including #startCoreDataAsyncWithCompletion:, or use
+ * #startCoreDataWithConfiguration:. Default is <tt>nil</tt>, that means one SQLite store on #SQLiteFilePath
+ * with automatic migration. The configuration is copied.
+ */
+@property(copy) JPDBManagerStoreConfiguration *storeConfiguration;
+
 /**
  * Configure the manager to automatically commit every operation.
  * Default value is <b>NO</b>. See \subpage basic_uses for more information.
@@ -70,9 +120,137 @@
  * 
  * If you enabled this option, you should be aware that at least some caveats/limitations have been identified.
  * Please refer to https://github.com/adam-roth/coredata-threadsafe documentation.
+ *
+ * Note that with this option every operation is performed on the thread that created the context. To run background
+ * work in parallel prefer the context pool, see #performBlock:.
  */
 @property(assign) BOOL enableThreadSafeOperation;
 
+/**
+ * Set as 'YES' to commit to the disk on background. Must be set before start the Core Data environment.<br>
+ * <br>
+ * When enabled the manager creates a two level stack: one private queue <b>writer context</b> owns the Persistent
+ * Store Coordinator and the #managedObjectContext is a main queue context child of him. The #commit method only push
+ * the changes to the writer context, that is cheap, and the writer context persist them to the disk asynchronously.
+ * Use #commitWithCompletion: to know when the changes reach the disk and #commitAndWait when you need that
+ * guarantee immediately. #closeCoreData always wait for pending commits.<br>
+ * Default value is <b>NO</b>.
+ */
+@property(assign) BOOL enableBackgroundCommit;
+
+/**
+ * How many private queue contexts the context pool used by #performBlock: should have.
+ * Must be set before the first #performBlock: call. Default value is <b>0</b>, one context per active processor.
+ */
+@property(assign) NSUInteger contextPoolSize;
+
+/**
+ * Set as 'YES' to cache the results of the queries that return records, as Object IDs.<br>
+ * <br>
+ * Repeated queries are answered from the #queryCache without going to the store, until some context saves changes
+ * on his Entity. Queries performed on a context with unsaved changes always go to the store.
+ * Default value is <b>NO</b>.
+ */
+@property(assign) BOOL enableQueryCache;
+
+/**
+ * The query result cache used when #enableQueryCache is set, <tt>nil</tt> otherwise.
+ * Use it to configure his limits and read his hit ratio.
+ */
+@property(readonly) JPDBManagerQueryCache *queryCache;
+
+/**
+ * Set as 'YES' to record the wall time, rows and fetch type of every query and the duration and changes
+ * of every commit on the #metrics. Default value is <b>NO</b>.
+ */
+@property(assign) BOOL enableMetrics;
+
+/**
+ * Latency histograms per Entity, commit totals and slow query log. <tt>nil</tt> if #enableMetrics isn't set.
+ */
+@property(readonly) JPDBManagerMetrics *metrics;
+
+/**
+ * Delegate that receive every query and commit event when #enableMetrics is set.
+ */
+@property(weak) id <JPDBManagerMetricsDelegate> metricsDelegate;
+
+/**
+ * Set as 'YES' to coalesce the automatic commits of the actions (see #automaticallyCommit and
+ * JPDBManagerAction::commitTransaction) into one save per #groupCommitInterval or #groupCommitThreshold writes,
+ * whatever comes first. A burst of small writes pays for one transaction instead of one each.<br>
+ * <br>
+ * Pending writes are saved by #flush, when the application goes to background and by #closeCoreData.
+ * Explicit calls to #commit aren't coalesced. Default value is <b>NO</b>.
+ */
+@property(assign, nonatomic) BOOL enableGroupCommit;
+
+/**
+ * Maximum time in seconds one write waits to be saved by the group commit.
+ * Default value is <b>0</b>, that means \ref JPDBManagerDefaultGroupCommitInterval.
+ */
+@property(assign) NSTimeInterval groupCommitInterval;
+
+/**
+ * Number of writes that triggers one group commit immediately.
+ * Default value is <b>0</b>, that means \ref JPDBManagerDefaultGroupCommitThreshold.
+ */
+@property(assign) NSUInteger groupCommitThreshold;
+
+/**
+ * How many writes the last group commit absorbed.
+ */
+@property(readonly) NSUInteger lastGroupCommitWrites;
+
+/**
+ * How many group commits were performed, and how many writes all of them absorbed.
+ * Divide them to know the average writes absorbed by each save.
+ */
+@property(readonly) NSUInteger groupCommits;
+
+/**
+ * Total of writes absorbed by the group commits. See #groupCommits.
+ */
+@property(readonly) NSUInteger groupCommitWrites;
+
+/**
+ * Set as 'YES' to keep bounded the memory used by the objects registered on the main context. When the
+ * limits of the #memoryGovernor are crossed, by queries or inserts, or when the application receives one memory
+ * warning, clean objects are turned back into faults. Limits crossed by one query or insert are collected on the next
+ * turn of the main queue, after the records were returned, and these records are kept. Default value is <b>NO</b>.
+ */
+@property(assign, nonatomic) BOOL enableMemoryGovernor;
+
+/**
+ * The governor of the main context when #enableMemoryGovernor is set, <tt>nil</tt> otherwise.
+ * Use it to configure his limits and policy, and read the statistics of his collections.
+ */
+@property(readonly) JPDBManagerMemoryGovernor *memoryGovernor;
+
+/**
+ * Set as 'YES' to publish the changes of every save as one diff per Entity on the #changeFeed.
+ * Default value is <b>NO</b>.
+ */
+@property(assign) BOOL enableChangeFeed;
+
+/**
+ * The feed of changes when #enableChangeFeed is set, <tt>nil</tt> otherwise. Subscribe to it to react to the
+ * records inserted, updated and deleted on the database:
+ * \code
+ * [manager.changeFeed subscribeToEntities:@[@"Product"] keys:@[@"price"] queue:nil block:^(NSArray *changes) {
+ *     for (JPDBManagerChange *change in changes)
+ *         [cache removeObjectsForKeys:[change.updatedObjectIDs allObjects]];
+ * }];
+ * \endcode
+ * Subscribing doesn't start the Core Data, and the subscriptions are kept when it's closed and started again.
+ */
+@property(readonly) JPDBManagerChangeFeed *changeFeed;
+
+/**
+ * <b>YES</b> while one block of #performTransaction: is running.
+ */
+@property(readonly) BOOL inTransaction;
+
 //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// 
 #pragma mark -
 #pragma mark Init Methods.
@@ -131,6 +309,67 @@
  */
 - (id)startCoreDataWithModel:(NSString *)modelName;
 
+/**
+ * Start Core Data elements using one model created on runtime, instead of loading one from the bundle.
+ * Useful on tests and benchmarks. See #startCoreData.
+ * @param anModel The Managed Object Model to use.
+ * @throw An \ref JPDBManagerStartException exception is raised if some error ocurrs. See \ref errors  for more informations.
+ * @return Return itself.
+ */
+- (id)startCoreDataWithManagedObjectModel:(NSManagedObjectModel *)anModel;
+
+/**
+ * Start Core Data elements opening the store as described by one configuration, like one of the profiles of
+ * JPDBManagerStoreConfiguration::configurationNamed:. See #startCoreData and #storeConfiguration.
+ * \code
+ * [manager startCoreDataWithConfiguration:[JPDBManagerStoreConfiguration configurationNamed:JPDBManagerStoreProfileWriteHeavy]];
+ * \endcode
+ * @param anConfiguration The store configuration.
+ * @throw An \ref JPDBManagerStartException exception is raised if some error ocurrs. See \ref errors  for more informations.
+ * @return Return itself.
+ */
+- (id)startCoreDataWithConfiguration:(JPDBManagerStoreConfiguration *)anConfiguration;
+
+/**
+ * Start Core Data elements asynchronously. Same as #startCoreData, but the slow work is performed on background:<br>
+ * - Wait until the protected data is available, observing the notification instead of polling.
+ * - Load the model.
+ * - Check if the store needs migration.
+ * - Open the store, migrating it when needed.
+ * - Warm up the store, loading the first page of every Entity.
+ * .
+ * The duration of every phase is available on #startupTimings. Blocks passed to #performWhenReady: are held until
+ * the store is ready. Synchronous accesses to the Core Data elements from background threads wait for it instead
+ * of starting again, but on the main thread they raise one \ref JPDBManagerStartException exception, since the
+ * startup needs the main thread to finish: use #performWhenReady: or the completion block.<br>
+ * <br>
+ * Errors opening the store doesn't raise exceptions, they're reported to the completion block and notified as any
+ * other error. One failed startup can be tried again. See \ref errors for more informations.
+ * @param completion Block called on the main queue when the main context is ready, or when the startup fails.
+ */
+- (void)startCoreDataAsyncWithCompletion:(void (^)(NSError *error))completion;
+
+/**
+ * Same as #startCoreDataAsyncWithCompletion:, using an specific model. See #startCoreDataWithModel:.
+ * @param modelName Specific Model Name including the extension.
+ * @param completion Block called on the main queue when the main context is ready, or when the startup fails.
+ */
+- (void)startCoreDataAsyncWithModel:(NSString *)modelName completion:(void (^)(NSError *error))completion;
+
+/**
+ * Same as #startCoreDataAsyncWithCompletion:, using one model created on runtime. See #startCoreDataWithManagedObjectModel:.
+ * @param anModel The Managed Object Model to use.
+ * @param completion Block called on the main queue when the main context is ready, or when the startup fails.
+ */
+- (void)startCoreDataAsyncWithManagedObjectModel:(NSManagedObjectModel *)anModel completion:(void (^)(NSError *error))completion;
+
+/**
+ * Perform one block on the main queue as soon as the store is ready.
+ * If the Core Data isn't being started asynchronously the block is performed immediately.
+ * Blocks are discarded if the startup fails.
+ */
+- (void)performWhenReady:(void (^)(void))block;
+
 /** 
  * Close Core Data Databases, commit pendent updates and release resources.
  */
@@ -141,6 +380,11 @@
  */
 - (void)removePersistentStore;
 
+/**
+ * Discard the cached Fetch Template predicates and reset #fetchTemplateCacheHits and #fetchTemplateCacheMisses.
+ */
+- (void)clearFetchTemplateCache;
+
 ///@}
 //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// 
 #pragma mark -
@@ -151,13 +395,13 @@
 ///@{
 
 /**
- * Return the NSEntityDescription for the specified entity.
+ * Return the NSEntityDescription for the specified entity. The name of his Managed Object class is also accepted.
  */
 - (NSEntityDescription *)entity:(NSString *)entityName;
 
 /**
  * Test if specified Entity exist on the model.
- * @param anEntityName The Entity Name.
+ * @param anEntityName The Entity Name, or the name of his Managed Object class.
  * @return YES if specified Entity exist on the model.
  */
 - (BOOL)existEntity:(NSString *)anEntityName;
@@ -165,7 +409,7 @@
 /**
  * Test if specified Attribute exist on specified Entity.
  * @param anAttributeName The Attribute name.
- * @param anEntityName The Entity name.
+ * @param anEntityName The Entity name, or the name of his Managed Object class.
  * @return <b>YES</b> if specified Attribute exist on specified Entity.
  */
 - (BOOL)existAttribute:(NSString *)anAttributeName inEntity:(NSString *)anEntityName;
@@ -176,11 +420,71 @@
  */
 - (JPDBManagerAction *)getDatabaseActionForEntity:(NSString *)anEntityName;
 
+/**
+ * Helper method to retrieve an \link JPDBManagerAction Database Action\endlink object that runs on an specific context,
+ * usually the one received by #performBlock:. The manager is automatically associated to this object.
+ * The action doesn't commit automatically, changes are committed at the end of the #performBlock: block.
+ */
+- (JPDBManagerAction *)getDatabaseActionForEntity:(NSString *)anEntityName inContext:(NSManagedObjectContext *)context;
+
 /**
  * Return an NSURL object that contains where the SQLite file is located.
  */
 - (NSURL *)SQLiteFilePath;
 
+///@}
+//// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// ////
+#pragma mark -
+#pragma mark Partition Methods.
+//// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// ////
+/** @name Partition Methods
+ */
+///@{
+
+/**
+ * Store some Entities on his own store file, under the same Persistent Store Coordinator. One partition has his
+ * own write lock and page cache, so high churn Entities doesn't slow down the read mostly ones, can be tuned apart
+ * and dropped as a whole with #resetPartition:error:. Entities not assigned to any partition stay on the main store,
+ * opened as described by #storeConfiguration.<br>
+ * <br>
+ * Partitions are model configurations: if the model already defines one configuration with this name, pass
+ * <tt>nil</tt> as Entities to use it. Sub entities go to the same partition of his parent.
+ * Relationships between Entities of different partitions aren't supported by the Core Data.<br>
+ * <br>
+ * Actions and new records are routed to the store of his Entity automatically.
+ * Partitions should be added before starting the Core Data.
+ * @param anName The partition name.
+ * @param entityNames Names of the Entities stored on this partition.
+ * @param anConfiguration How the partition store is opened. Pass <tt>nil</tt> to use one SQLite file
+ * named after the partition, next to #SQLiteFilePath. If the configuration has no store URL the same file is used.
+ * @throw An \ref JPDBManagerStartException exception is raised if the Core Data was already started.
+ */
+- (void)addPartition:(NSString *)anName entities:(NSArray *)entityNames configuration:(JPDBManagerStoreConfiguration *)anConfiguration;
+
+/**
+ * Names of the partitions added.
+ */
+- (NSArray *)partitions;
+
+/**
+ * The store of one partition. <tt>nil</tt> if the partition doesn't exist or the Core Data wasn't started.
+ */
+- (NSPersistentStore *)persistentStoreOfPartition:(NSString *)anName;
+
+/**
+ * The store where the records of one Entity are saved. <tt>nil</tt> if there's no partition
+ * or the Core Data wasn't started.
+ */
+- (NSPersistentStore *)persistentStoreForEntity:(NSString *)anEntityName;
+
+/**
+ * Drop every record of one partition, destroying and recreating his store.<br>
+ * Every context is reset first, objects held by the application became invalid and unsaved changes are lost.
+ * Call it on the main thread.
+ * @return <b>YES</b> if the partition was recreated.
+ */
+- (BOOL)resetPartition:(NSString *)anName error:(NSError **)error;
+
 ///@}
 //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// 
 #pragma mark -
@@ -192,8 +496,86 @@
 
 /**
  * Commit al pendent operations to the persistent store.
+ * If #enableBackgroundCommit is <b>YES</b> the changes are persisted to the disk asynchronously.
  */
 - (void)commit;
 
+/**
+ * Commit al pendent operations to the persistent store and call the block when they're on the disk.
+ * @param completion Block called on the main queue. Receive the error if the commit fails, or <tt>nil</tt>.
+ */
+- (void)commitWithCompletion:(void (^)(NSError *error))completion;
+
+/**
+ * Commit al pendent operations to the persistent store and wait until they, and all previous commits, are on the disk.
+ * This is the durability barrier for #enableBackgroundCommit, use it when the application will be terminated.
+ */
+- (void)commitAndWait;
+
+/**
+ * Save now the writes coalesced by the group commit and wait until they are on the disk.
+ * Can be called even if #enableGroupCommit isn't set, then it's the same as #commitAndWait.
+ */
+- (void)flush;
+
+///@}
+//// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// ////
+#pragma mark -
+#pragma mark Transaction Methods.
+//// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// ////
+/** @name Transaction Methods
+ */
+///@{
+
+/**
+ * Perform one unit of work on the main context and commit it once. Automatic commits and calls to #commit
+ * made by the block are suspended, so updates on many records of many Entities cost one save. Commits made
+ * by other threads meanwhile wait for the transaction to finish, so the block shouldn't wait for them.<br>
+ * <br>
+ * If the block returns <b>NO</b> or raises one exception every change made by him is rolled back,
+ * the exception is raised again after it. Transactions can be nested, rolling back one nested transaction
+ * only discard his own changes and the outer transaction decides if the remaining ones are committed.
+ * Errors returned by the block, or by the commit, are notified as <b>JPDBManagerErrorNotification</b>.
+ *
+ * \code
+ * [manager performTransaction:^BOOL(NSError **error) {
+ *     [[manager getDatabaseActionForEntity:@"Account"] deleteRecord:from];
+ *     [[[manager getDatabaseActionForEntity:@"Transfer"] createNewRecord] setValue:@100 forKey:@"amount"];
+ *     return YES;
+ * }];
+ * \endcode
+ *
+ * @param block Block performed on the main context queue. Return <b>NO</b> to roll back, optionally setting the error.
+ * @return <b>YES</b> if the changes were committed, or will be committed by the outer transaction.
+ */
+- (BOOL)performTransaction:(BOOL (^)(NSError **error))block;
+
+///@}
+//// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// ////
+#pragma mark -
+#pragma mark Concurrency Methods.
+//// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// ////
+/** @name Concurrency Methods
+ * The manager owns a pool of private queue contexts that share the Persistent Store Coordinator, each one confined
+ * to his own serial queue. Work performed with this methods runs in parallel with the main context and with each other.
+ * When the block finish the context is committed, and the committed changes are merged back on the main context
+ * and on the other contexts of the pool. The pool is created on the first call.
+ */
+///@{
+
+/**
+ * Asynchronously perform one block on the less busy context of the pool.
+ * Objects of this context should only be used inside the block. To pass objects to other contexts use his
+ * <b>objectID</b>. Use #getDatabaseActionForEntity:inContext: to perform Database Actions inside the block.
+ * @param block The block receive the context and is performed on the context queue.
+ */
+- (void)performBlock:(void (^)(NSManagedObjectContext *context))block;
+
+/**
+ * Synchronously perform one block on the less busy context of the pool. See #performBlock:.
+ * @param block The block receive the context and is performed on the context queue.
+ */
+- (void)performBlockAndWait:(void (^)(NSManagedObjectContext *context))block;
+
 ///@}
 @end
@@ -16,14 +16,64 @@
 #import "JPCore.h"
 #import "JPDBManager.h"
 #import "JPDBManagerAction.h"
+#import "JPDBManagerContextPool.h"
+#import "JPDBManagerMetadata.h"
+#import "JPDBManagerQueryCache.h"
+#import "JPDBManagerMemoryGovernor.h"
+#import "JPDBManagerMetrics.h"
+#import "JPDBManagerStoreConfiguration.h"
+#import "JPDBManagerChangeFeed.h"
 
 @interface JPDBManager () {
     NSManagedObjectModel *_managedObjectModel;
+    JPDBManagerMetadata *_metadata;
+
+    // Fetch Template predicates, keyed by template name, and his bound predicates, keyed by variables.
+    NSMutableDictionary *_fetchTemplateCache;
+    NSMutableDictionary *_boundFetchTemplates;
+    NSUInteger _fetchTemplateCacheHits;
+    NSUInteger _fetchTemplateCacheMisses;
+
+    // Context -> "Entity.key" -> value -> record.
+    NSMapTable *_identityMaps;
+    JPDBManagerQueryCache *_queryCache;
+    JPDBManagerMetrics *_metrics;
+    JPDBManagerMemoryGovernor *_memoryGovernor;
+    NSMutableArray *_sparedRecords;
+    JPDBManagerChangeFeed *_changeFeed;
+
+    // Group commit.
+    NSUInteger _pendingWrites;
+    NSUInteger _groupCommitGeneration;
+    BOOL _groupCommitScheduled;
+
+    // Partitions: name -> store configuration and name -> Entity names.
+    NSMutableDictionary *_partitionConfigurations;
+    NSMutableDictionary *_partitionEntities;
+    NSDictionary *_partitionOfEntity;
+
+    // Transactions. The depth and thread are guarded by the condition, commits of other threads wait on it.
+    NSUInteger _transactionDepth;
+    NSThread *_transactionThread;
+    NSCondition *_transactionCondition;
+    BOOL _transactionOwnsUndoManager;
+
     NSManagedObjectContext *_managedObjectContext;
     NSPersistentStoreCoordinator *_persistentStoreCoordinator;
+    NSManagedObjectContext *_writerContext;
+    JPDBManagerContextPool *_contextPool;
+
+    // Asynchronous startup.
+    dispatch_group_t _startupGroup;
+    dispatch_queue_t _startupQueue;
+    NSMutableDictionary *_startupTimings;
+    NSError *_startupError;
 }
 @end
 
+// Identify the asynchronous startup queue.
+static char JPDBManagerStartupQueueKey;
+
 @implementation JPDBManager
 
 #pragma mark - Init Methods.
@@ -42,6 +92,13 @@
 
 
 
+- (void)dealloc {
+    [[NSNotificationCenter defaultCenter] removeObserver:self];
+}
+
+
+
+
 #pragma mark - Notifications Methods.
 - (void)notificateError:(NSError *)anError {
 
@@ -93,20 +150,157 @@
     return self;
 }
 
+// Start Core Data Databases. Using an model created on runtime.
+- (id)startCoreDataWithManagedObjectModel:(NSManagedObjectModel *)anModel {
+
+    // Index the model, as if loaded from the bundle.
+    _managedObjectModel = anModel;
+    _metadata = [JPDBManagerMetadata initWithModel:anModel];
+
+    // Continue.
+    [self startCoreData];
+
+    // Return ourselves.
+    return self;
+}
+
+// Start Core Data Databases. Opening the store as described by one configuration.
+- (id)startCoreDataWithConfiguration:(JPDBManagerStoreConfiguration *)anConfiguration {
+
+    // Used when the coordinator is created.
+    self.storeConfiguration = anConfiguration;
+
+    // Continue.
+    [self startCoreData];
+
+    // Return ourselves.
+    return self;
+}
+
+- (void)startCoreDataAsyncWithModel:(NSString *)modelName completion:(void (^)(NSError *error))completion {
+
+    // Dealloc if needed and set.
+    _loadedModelName = [modelName copy];
+
+    // Continue.
+    [self startCoreDataAsyncWithCompletion:completion];
+}
+
+- (void)startCoreDataAsyncWithManagedObjectModel:(NSManagedObjectModel *)anModel completion:(void (^)(NSError *error))completion {
+
+    // Index the model, as if loaded from the bundle.
+    _managedObjectModel = anModel;
+    _metadata = [JPDBManagerMetadata initWithModel:anModel];
+
+    // Continue.
+    [self startCoreDataAsyncWithCompletion:completion];
+}
+
+- (void)startCoreDataAsyncWithCompletion:(void (^)(NSError *error))completion {
+    dispatch_group_t group;
+
+    @synchronized (self) {
+
+        // Already started, or starting.
+        if (_persistentStoreCoordinator || _startupGroup) {
+            dispatch_group_notify(_startupGroup ?: dispatch_group_create(), dispatch_get_main_queue(), ^{
+                if (completion)
+                    completion(_startupError);
+            });
+            return;
+        }
+
+        _startupQueue = dispatch_queue_create("org.seqoy.jump.database.startup", DISPATCH_QUEUE_SERIAL);
+        dispatch_queue_set_specific(_startupQueue, &JPDBManagerStartupQueueKey, &JPDBManagerStartupQueueKey, NULL);
+
+        _startupTimings = [NSMutableDictionary new];
+        _startupError = nil;
+
+        group = _startupGroup = dispatch_group_create();
+        dispatch_group_enter(group);
+    }
+
+    CFAbsoluteTime start = CFAbsoluteTimeGetCurrent();
+
+    // This is the first block notified, so it runs before any block passed to 'performWhenReady:'.
+    dispatch_group_notify(group, dispatch_get_main_queue(), ^{
+        _startupTimings[JPDBManagerStartupPhaseTotal] = @(CFAbsoluteTimeGetCurrent() - start);
+
+        if (completion)
+            completion(_startupError);
+    });
+
+    // Wait for the protected data and open everything on background.
+    [self waitForProtectedData:^{
+        _startupTimings[JPDBManagerStartupPhaseProtectedData] = @(CFAbsoluteTimeGetCurrent() - start);
+
+        dispatch_async(_startupQueue, ^{
+            [self openCoreDataOnStartupQueue];
+
+            // The main context belongs to the main thread, the startup only finishes when it exists.
+            dispatch_async(dispatch_get_main_queue(), ^{
+                [self finishAsyncStartup:group];
+            });
+        });
+    }];
+}
+
+// Create the contexts, and finish the startup. This is called on the main thread.
+- (void)finishAsyncStartup:(dispatch_group_t)group {
+
+    // From now on, every access goes through the synchronous path. A failed startup can be tried again.
+    @synchronized (self) {
+        _startupGroup = nil;
+        _startupQueue = nil;
+    }
+
+    if (!_startupError)
+        [self startCoreData];
+
+    dispatch_group_leave(group);
+}
+
+- (void)performWhenReady:(void (^)(void))block {
+    dispatch_group_t group = _startupGroup;
+
+    // Not starting asynchronously.
+    if (!group) {
+        block();
+        return;
+    }
+
+    dispatch_group_notify(group, dispatch_get_main_queue(), ^{
+        if (!_startupError)
+            block();
+    });
+}
+
+- (BOOL)isReady {
+    return _persistentStoreCoordinator != nil;
+}
+
+- (NSDictionary *)startupTimings {
+    return [_startupTimings copy];
+}
+
 // Close Core Data Database.
 - (void)closeCoreData {
 
+    // Let the background work finish before close.
+    [_contextPool waitUntilAllBlocksAreFinished];
+
     //////
-    // Commit data.
-    [self commit];
+    // Commit data, including the coalesced writes, and wait until it is on the disk.
+    [self flush];
 
-    _managedObjectModel = nil;
-    _managedObjectContext = nil;
-    _persistentStoreCoordinator = nil;
+    [self releaseCoreData];
 }
 
 - (void)removePersistentStore {
 
+    // Let the background work finish before close.
+    [_contextPool waitUntilAllBlocksAreFinished];
+
     // Error control.
     NSError *anError = nil;
 
@@ -116,14 +310,38 @@
     }
 
     // Close it.
+    [self releaseCoreData];
+}
+
+// Release all Core Data elements.
+- (void)releaseCoreData {
+    [[NSNotificationCenter defaultCenter] removeObserver:self name:NSManagedObjectContextDidSaveNotification object:nil];
+    [self stopIndexingContexts];
+
+    _contextPool = nil;
     _managedObjectModel = nil;
+    _metadata = nil;
+    _queryCache = nil;
+    _memoryGovernor = nil;
+    _changeFeed.coordinator = nil;
+    [self clearFetchTemplateCache];
     _managedObjectContext = nil;
+    _writerContext = nil;
+    _startupGroup = nil;
     _persistentStoreCoordinator = nil;
 }
 
 - (JPDBManagerAction *)getDatabaseActionForEntity:(NSString *)anEntityName {
     JPDBManagerAction *instance = [JPDBManagerAction initWithEntityName:anEntityName andManager:self];
     instance.commitTransaction = self.automaticallyCommit;
+    [self routeAction:instance];
+    return instance;
+}
+
+- (JPDBManagerAction *)getDatabaseActionForEntity:(NSString *)anEntityName inContext:(NSManagedObjectContext *)context {
+    JPDBManagerAction *instance = [JPDBManagerAction initWithEntityName:anEntityName andManager:self];
+    instance.context = context;
+    [self routeAction:instance];
     return instance;
 }
 
@@ -132,6 +350,135 @@
 
 #pragma mark - Core Data Stack (Private Methods).
 
+// Perform the block on the main thread once the protected data is available, observing
+// the notification instead of polling. More info on the 'persistentStoreCoordinator' accessor.
+- (void)waitForProtectedData:(void (^)(void))block {
+    void (^check)(void) = ^{
+        if ([[UIApplication sharedApplication] isProtectedDataAvailable]) {
+            block();
+            return;
+        }
+
+        __block id observer;
+        observer = [[NSNotificationCenter defaultCenter] addObserverForName:UIApplicationProtectedDataDidBecomeAvailable
+                                                                     object:nil
+                                                                      queue:[NSOperationQueue mainQueue]
+                                                                 usingBlock:^(NSNotification *notification) {
+                                                                     [[NSNotificationCenter defaultCenter] removeObserver:observer];
+                                                                     block();
+                                                                 }];
+    };
+
+    if ([NSThread isMainThread])
+        check();
+    else
+        dispatch_async(dispatch_get_main_queue(), check);
+}
+
+// Load the model and open the store, timing every phase. This is called on the startup queue.
+- (void)openCoreDataOnStartupQueue {
+    CFAbsoluteTime phase = CFAbsoluteTimeGetCurrent();
+
+    ////// ////// //////
+    // Load the model.
+    @try {
+        [self managedObjectModel];
+    }
+    @catch (NSException *exception) {
+        _startupError = [NSError errorWithDomain:JPDBManagerStartException code:0
+                                        userInfo:@{NSLocalizedDescriptionKey : exception.reason ?: exception.name}];
+    }
+    _startupTimings[JPDBManagerStartupPhaseModelLoad] = @(CFAbsoluteTimeGetCurrent() - phase);
+
+    ////// ////// //////
+    // Check if the store needs migration.
+    if (!_startupError) {
+        phase = CFAbsoluteTimeGetCurrent();
+
+        // In-memory stores are always new.
+        JPDBManagerStoreConfiguration *configuration = [self currentStoreConfiguration];
+        NSURL *storeURL = [self storeURLOfConfiguration:configuration];
+
+        NSDictionary *metadata = !storeURL ? nil
+                : [NSPersistentStoreCoordinator metadataForPersistentStoreOfType:configuration.storeType
+                                                                             URL:storeURL
+                                                                           error:NULL];
+        _storeRequiredMigration = metadata != nil
+                && ![_managedObjectModel isConfiguration:nil compatibleWithStoreMetadata:metadata];
+
+        _startupTimings[JPDBManagerStartupPhaseMigrationCheck] = @(CFAbsoluteTimeGetCurrent() - phase);
+    }
+
+    ////// ////// //////
+    // Open the store.
+    if (!_startupError) {
+        phase = CFAbsoluteTimeGetCurrent();
+
+        NSError *error = nil;
+        @try {
+            if (![self openPersistentStoreCoordinator:&error])
+                _startupError = error;
+        }
+        @catch (NSException *exception) {
+            _startupError = [NSError errorWithDomain:JPDBManagerStartException code:0
+                                            userInfo:@{NSLocalizedDescriptionKey : exception.reason ?: exception.name}];
+        }
+
+        _startupTimings[JPDBManagerStartupPhaseStoreOpen] = @(CFAbsoluteTimeGetCurrent() - phase);
+    }
+
+    ////// ////// //////
+    // Warm up.
+    if (!_startupError) {
+        phase = CFAbsoluteTimeGetCurrent();
+        [self warmUpStore];
+        _startupTimings[JPDBManagerStartupPhaseWarmUp] = @(CFAbsoluteTimeGetCurrent() - phase);
+    }
+
+    // Notificate the error.
+    if (_startupError) {
+        NSError *anError = _startupError;
+        dispatch_async(dispatch_get_main_queue(), ^{
+            [self notificateError:anError];
+        });
+    }
+}
+
+// Open the SQLite connection and load the first page of every Entity, so the first queries doesn't pay for it.
+- (void)warmUpStore {
+    NSManagedObjectContext *context = [[NSManagedObjectContext alloc] initWithConcurrencyType:NSPrivateQueueConcurrencyType];
+    [context setPersistentStoreCoordinator:_persistentStoreCoordinator];
+
+    [context performBlockAndWait:^{
+        for (NSEntityDescription *entity in [_managedObjectModel entities]) {
+            if ([entity isAbstract])
+                continue;
+
+            NSFetchRequest *request = [NSFetchRequest fetchRequestWithEntityName:entity.name];
+            request.fetchLimit = 1;
+
+            [context executeFetchRequest:request error:NULL];
+        }
+    }];
+}
+
+// Wait the asynchronous startup, if one is running. Synchronous accesses are held here until the store is ready.
+- (void)waitForAsyncStartup {
+    dispatch_group_t group = _startupGroup;
+
+    // Not starting asynchronously, or we're the startup itself.
+    if (!group || dispatch_get_specific(&JPDBManagerStartupQueueKey))
+        return;
+
+    // The startup needs the main thread to receive the protected data notification and create the main context,
+    // waiting here would deadlock. Building the stack again would race with the startup.
+    if ([NSThread isMainThread])
+        [NSException raise:JPDBManagerStartException
+                    format:@"The Core Data is being started asynchronously, use 'performWhenReady:' to access it on the main thread."];
+
+    dispatch_group_wait(group, DISPATCH_TIME_FOREVER);
+}
+
 // Returns the path to the application's documents directory.
 - (NSString *)applicationDocumentsDirectory {
 
@@ -160,6 +507,12 @@
         return _managedObjectModel;
     }
 
+    // If is being started asynchronously, wait for it.
+    [self waitForAsyncStartup];
+    if (_managedObjectModel != nil) {
+        return _managedObjectModel;
+    }
+
     ////// ////// //////
     // If defined an Model Name, search for him on bundle.
     if (_loadedModelName) {
@@ -188,6 +541,9 @@
         _managedObjectModel = [NSManagedObjectModel mergedModelFromBundles:nil];
     }
 
+    // Index the model once, every validation reads from this index.
+    _metadata = [JPDBManagerMetadata initWithModel:_managedObjectModel];
+
     // Return Managed Object Model.
     return _managedObjectModel;
 }
@@ -208,6 +564,12 @@
         return _persistentStoreCoordinator;
     }
 
+    // If is being started asynchronously, wait for it.
+    [self waitForAsyncStartup];
+    if (_persistentStoreCoordinator != nil) {
+        return _persistentStoreCoordinator;
+    }
+
     //
     // We're waiting until Protected Data is Available before try to start the Core Data environment.
     // More info here: http://stackoverflow.com/questions/12845790/how-to-debug-handle-intermittent-authorization-denied-and-disk-i-o-errors-wh
@@ -218,35 +580,12 @@
 
     ////// ////// //////
 
-    // Main Database Path.
-    NSURL *mainDatabase = [self SQLiteFilePath];
-
     // Error Control.
     NSError *error = nil;
 
     ////// ////// //////
-    // Alloc and Init Persistent Coordinator.
-    _persistentStoreCoordinator = [[NSPersistentStoreCoordinator alloc] initWithManagedObjectModel:self.managedObjectModel];
-
-    ////// ////// //////
-    //
-    // Options to pass to persistent store. http://developer.apple.com/iphone/library/documentation/Cocoa/Conceptual/CoreDataVersioning/Articles/vmMappingOverview.html
-    //
-    NSDictionary *options = @{
-
-            NSMigratePersistentStoresAutomaticallyOption : @YES,
-
-            // Attempt to create the mapping model automatically.
-            NSInferMappingModelAutomaticallyOption       : @YES
-    };
-
-    ////// ////// //////
-    // Add JPL to the Persistent, control error above.
-    if (![_persistentStoreCoordinator addPersistentStoreWithType:NSSQLiteStoreType
-                                                   configuration:nil
-                                                             URL:mainDatabase
-                                                         options:options
-                                                           error:&error]) {
+    // Open the store, control error above.
+    if (![self openPersistentStoreCoordinator:&error]) {
 
         ////// ////// //////
         // Handle error.
@@ -260,6 +599,67 @@
     return _persistentStoreCoordinator;
 }
 
+// Store configuration in use, the default one if none was set.
+- (JPDBManagerStoreConfiguration *)currentStoreConfiguration {
+    return self.storeConfiguration ?: [JPDBManagerStoreConfiguration init];
+}
+
+// Where the store of one configuration is located, nil for in-memory stores.
+- (NSURL *)storeURLOfConfiguration:(JPDBManagerStoreConfiguration *)anConfiguration {
+    if ([anConfiguration.storeType isEqualToString:NSInMemoryStoreType])
+        return nil;
+
+    return anConfiguration.storeURL ?: [self SQLiteFilePath];
+}
+
+// Create the Persistent Store Coordinator and add the application's store to it.
+- (BOOL)openPersistentStoreCoordinator:(NSError **)error {
+
+    // Store type, location and options.
+    JPDBManagerStoreConfiguration *configuration = [self currentStoreConfiguration];
+
+    ////// ////// //////
+    // Without partitions every Entity goes to the main store. The model can't be changed
+    // once the coordinator uses him, so partitions are applied first.
+    NSString *mainConfiguration = [self applyPartitionsToModel:self.managedObjectModel]
+            ? JPDBManagerDefaultPartition : nil;
+
+    ////// ////// //////
+    // Alloc and Init Persistent Coordinator.
+    NSPersistentStoreCoordinator *coordinator = [[NSPersistentStoreCoordinator alloc]
+            initWithManagedObjectModel:self.managedObjectModel];
+
+    ////// ////// //////
+    //
+    // Options to pass to persistent store: migration, read-only and SQLite pragmas.
+    // http://developer.apple.com/iphone/library/documentation/Cocoa/Conceptual/CoreDataVersioning/Articles/vmMappingOverview.html
+    //
+    NSDictionary *options = [configuration storeOptions];
+
+    ////// ////// //////
+    // Add JPL to the Persistent.
+    if (![coordinator addPersistentStoreWithType:configuration.storeType
+                                   configuration:mainConfiguration
+                                             URL:[self storeURLOfConfiguration:configuration]
+                                         options:options
+                                           error:error]) {
+        return NO;
+    }
+
+    ////// ////// //////
+    // One store per partition.
+    for (NSString *partition in [self partitions]) {
+        if (![self addStoreOfPartition:partition toCoordinator:coordinator error:error])
+            return NO;
+    }
+
+    _persistentStoreCoordinator = coordinator;
+
+    // Subscriptions are kept between starts, publish the saves of the new coordinator.
+    _changeFeed.coordinator = coordinator;
+    return YES;
+}
+
 //
 // Managed Object Context Accessor. If the context doesn't already exist, it is created and bound to
 // the persistent store coordinator for the application.
@@ -273,121 +673,594 @@
         return _managedObjectContext;
     }
 
-    // Alloc and Start.
-    _managedObjectContext = self.enableThreadSafeOperation
-            ? [[IAThreadSafeContext alloc] init]
-            : [[NSManagedObjectContext alloc] init];
+    // If is being started asynchronously, wait for it. The startup creates the contexts on the main thread.
+    [self waitForAsyncStartup];
+    if (_managedObjectContext != nil) {
+        return _managedObjectContext;
+    }
 
-    [_managedObjectContext setPersistentStoreCoordinator:self.persistentStoreCoordinator];
+    Class contextClass = self.enableThreadSafeOperation ? [IAThreadSafeContext class] : [NSManagedObjectContext class];
 
-    // Return.
-    return _managedObjectContext;
-}
+    ////// ////// //////
+    // Two level stack, the main context is child of the writer context.
+    if (self.enableBackgroundCommit) {
 
+        // The writer context owns the coordinator and write to the disk on his own queue.
+        _writerContext = [[NSManagedObjectContext alloc] initWithConcurrencyType:NSPrivateQueueConcurrencyType];
+        [_writerContext setPersistentStoreCoordinator:self.persistentStoreCoordinator];
+        [_writerContext setMergePolicy:NSMergeByPropertyObjectTrumpMergePolicy];
 
+        _managedObjectContext = [[contextClass alloc] initWithConcurrencyType:NSMainQueueConcurrencyType];
+        [_managedObjectContext setParentContext:_writerContext];
 
-#pragma mark - Checking Methods. 
-- (NSEntityDescription *)entity:(NSString *)entityName {
-    return [NSEntityDescription entityForName:entityName inManagedObjectContext:self.managedObjectContext];;
-}
+        // Changes written to the disk are merged on the context pool.
+        [self observeSavesOfContext:_writerContext];
+    }
 
+    ////// ////// //////
+    // Single context stack.
+    else {
+        _managedObjectContext = [[contextClass alloc] init];
+        [_managedObjectContext setPersistentStoreCoordinator:self.persistentStoreCoordinator];
 
-// Return YES if specified Entity exist on the model.
-- (BOOL)existEntity:(NSString *)anEntityName {
-    return [self entity:anEntityName] != nil;
-}
+        // Changes committed on this context are merged on the context pool.
+        [self observeSavesOfContext:_managedObjectContext];
+    }
 
+    // Return.
+    return _managedObjectContext;
+}
 
-// Return YES if specified Attribute exist on specified Entity.
-- (BOOL)existAttribute:(NSString *)anAttributeName inEntity:(NSString *)anEntityName {
+//
+// Context Pool Accessor. If the pool doesn't already exist, it is created and bound to
+// the persistent store coordinator for the application.
+//
+- (JPDBManagerContextPool *)contextPool {
 
-    if (![self existEntity:anEntityName])
-        return NO;
+    // Wait outside of the lock, the startup takes it when finishing.
+    [self waitForAsyncStartup];
 
-    // Retrieve the Entity.
-    NSEntityDescription *entity = [NSEntityDescription entityForName:anEntityName
-                                              inManagedObjectContext:self.managedObjectContext];
+    @synchronized (self) {
+        if (_contextPool == nil) {
+            _contextPool = [JPDBManagerContextPool initWithCoordinator:self.persistentStoreCoordinator
+                                                                  size:self.contextPoolSize
+                                                           mergePolicy:NSMergeByPropertyObjectTrumpMergePolicy];
 
-    // Test if exist this attribute.
-    return entity.attributesByName[anAttributeName] != nil;
+            for (NSManagedObjectContext *context in _contextPool.contexts)
+                [self observeSavesOfContext:context];
+        }
+    }
+    return _contextPool;
 }
 
+// Rebuild one cached result. Faults are enough unless the query wants full objects or prefetching, then the
+// records missing on the context are fetched by his Object IDs, keeping the cached order.
+- (NSArray *)recordsWithObjectIDs:(NSArray *)objectIDs ofRequest:(NSFetchRequest *)request inContext:(NSManagedObjectContext *)context {
+    BOOL needsFetch = [request.relationshipKeyPathsForPrefetching count] > 0;
+    NSMutableArray *records = [NSMutableArray arrayWithCapacity:[objectIDs count]];
+
+    for (NSManagedObjectID *objectID in objectIDs) {
+        if (needsFetch)
+            break;
+
+        NSManagedObject *record = request.returnsObjectsAsFaults ? [context objectWithID:objectID]
+                                                                 : [context objectRegisteredForID:objectID];
+        if (!record || (!request.returnsObjectsAsFaults && [record isFault]))
+            needsFetch = YES;
+        else
+            [records addObject:record];
+    }
 
+    if (!needsFetch)
+        return records;
 
+    NSFetchRequest *byObjectIDs = [NSFetchRequest new];
+    byObjectIDs.entity = request.entity;
+    byObjectIDs.predicate = [NSPredicate predicateWithFormat:@"self IN %@", objectIDs];
+    byObjectIDs.includesSubentities = request.includesSubentities;
+    byObjectIDs.returnsObjectsAsFaults = request.returnsObjectsAsFaults;
+    byObjectIDs.relationshipKeyPathsForPrefetching = request.relationshipKeyPathsForPrefetching;
 
-#pragma mark - Database Action Methods.
+    NSError *error = nil;
+    NSArray *fetched = [context executeFetchRequest:byObjectIDs error:&error];
+    if (!fetched) {
+        if (error)
+            [self notificateError:error];
+        return nil;
+    }
 
-- (void)checkActionParameters:(JPDBManagerAction *)anAction {
-    [self throwIfNilObject:anAction
-                 withCause:@"Can't perform an Database Action because an Action wasn't passed."];
+    NSMutableDictionary *recordsByID = [NSMutableDictionary dictionaryWithCapacity:[fetched count]];
+    for (NSManagedObject *record in fetched)
+        recordsByID[record.objectID] = record;
 
-    [self throwIfNilObject:anAction.entity
-                 withCause:@"Can't perform an Database Action because the 'entity' property isn't setted."];
+    // Records deleted meanwhile are left out.
+    [records removeAllObjects];
+    for (NSManagedObjectID *objectID in objectIDs) {
+        if (recordsByID[objectID])
+            [records addObject:recordsByID[objectID]];
+    }
+    return records;
 }
 
-// Build fetch template using...
-- (JPDBManagerAction *)loadFetchTemplateWithAction:(JPDBManagerAction *)anAction {
-
-    NSFetchRequest *request = anAction.fetchVariables
+// Context that should perform one action. Actions without an specific context runs on the main context.
+- (NSManagedObjectContext *)contextForAction:(JPDBManagerAction *)anAction {
+    return anAction.context ?: self.managedObjectContext;
+}
 
-            ? [self.managedObjectModel fetchRequestFromTemplateWithName:anAction.fetchTemplate
-                                                  substitutionVariables:anAction.fetchVariables]
+//
+// Query Cache Accessor. Created on the first use and bound to the persistent store coordinator.
+//
+- (JPDBManagerQueryCache *)queryCache {
+    if (!self.enableQueryCache)
+        return nil;
 
-            : [self.managedObjectModel fetchRequestTemplateForName:anAction.fetchTemplate];
+    // Wait outside of the lock, the startup takes it when finishing.
+    [self waitForAsyncStartup];
 
-    // Check if exist.
-    [self throwIfNilObject:request
-                 withCause:NSFormatString( @"The Fetch Template '%@' for Entity '%@' doesn't "
-                         @"exist on the Model.", anAction.fetchTemplate, anAction.entityName )];
+    @synchronized (self) {
+        if (_queryCache == nil)
+            _queryCache = [JPDBManagerQueryCache initWithCoordinator:self.persistentStoreCoordinator];
+    }
+    return _queryCache;
+}
 
-    // Assign the predicate created.
-    anAction.predicate = request.predicate;
+//
+// Metrics Accessor. Created on the first use, kept when the Core Data is closed.
+//
+- (JPDBManagerMetrics *)metrics {
+    if (!self.enableMetrics)
+        return nil;
 
-    return anAction;
+    @synchronized (self) {
+        if (_metrics == nil)
+            _metrics = [JPDBManagerMetrics new];
+    }
+    return _metrics;
 }
 
+//
+// Change Feed Accessor. Created on the first use and kept when the Core Data is closed. Bound to the
+// persistent store coordinator when he's opened, so subscribing doesn't start the Core Data.
+//
+- (JPDBManagerChangeFeed *)changeFeed {
+    if (!self.enableChangeFeed)
+        return nil;
 
-// This method is called from the JPDBManagerAction as an private call. 
-- (id)performDatabaseActionInternally:(JPDBManagerAction *)request {
+    @synchronized (self) {
+        if (_changeFeed == nil)
+            _changeFeed = [JPDBManagerChangeFeed initWithCoordinator:_persistentStoreCoordinator];
 
-    // Check Parameters.
-    [self checkActionParameters:request];
+        // The coordinator may be opened while the feed was created.
+        if (!_changeFeed.coordinator)
+            _changeFeed.coordinator = _persistentStoreCoordinator;
+    }
+    return _changeFeed;
+}
 
-    // Build an query using Fetch template, if defined.
-    if (request.fetchTemplate)
-        request = [self loadFetchTemplateWithAction:request];
+//
+// Memory Governor Accessor. Created on the first use, once the main context exists.
+//
+- (JPDBManagerMemoryGovernor *)memoryGovernor {
+    if (!self.enableMemoryGovernor || !_managedObjectContext)
+        return nil;
 
-    // Execute Fetch.
-    return [self runRequest:request];
+    @synchronized (self) {
+        if (_memoryGovernor == nil)
+            _memoryGovernor = [JPDBManagerMemoryGovernor initWithContext:_managedObjectContext];
+    }
+    return _memoryGovernor;
 }
 
-- (id)runRequest:(JPDBManagerAction *)request {
+// In-memory index of one unique key, on the context of one action. Contexts are held weakly,
+// so the indexes of the released contexts are released too. Synchronize on the returned map to use it.
+// The index is built once from the records registered on the context, then kept up to date as records
+// are fetched, inserted or changed. This is called on the context queue.
+- (NSMapTable *)identityMapForKey:(NSString *)anKey ofAction:(JPDBManagerAction *)anAction {
+    NSManagedObjectContext *context = [self contextForAction:anAction];
+    NSString *name = NSFormatString( @"%@.%@", anAction.entityName, anKey );
+    NSMapTable *identityMap;
+
+    @synchronized (self) {
+        if (!_identityMaps)
+            _identityMaps = [NSMapTable weakToStrongObjectsMapTable];
+
+        NSMutableDictionary *maps = [_identityMaps objectForKey:context];
+        if (!maps) {
+            maps = [NSMutableDictionary dictionary];
+            [_identityMaps setObject:maps forKey:context];
+
+            [[NSNotificationCenter defaultCenter] addObserver:self
+                                                     selector:@selector(contextObjectsDidChange:)
+                                                         name:NSManagedObjectContextObjectsDidChangeNotification
+                                                       object:context];
+        }
 
-    // Return Data as Arrays.
-    if (request.returnActionAsArray) {
+        identityMap = maps[name];
+        if (identityMap)
+            return identityMap;
 
-        // Error Control.
-        NSError *error = nil;
+        identityMap = [NSMapTable strongToWeakObjectsMapTable];
+        maps[name] = identityMap;
+    }
 
-        // Execute the Fetch Requester.
-        id queryResult = [self.managedObjectContext executeFetchRequest:request
-                                                                  error:&error];
+    // Seed the new index, from now on he is only updated.
+    [self indexRecords:[context registeredObjects] onIdentityMap:identityMap named:name];
 
-        // Notificate the error.
-        if (error)
-            [self notificateError:error];
+    return identityMap;
+}
 
-        // Return data.
-        return queryResult;
+// Index the records of one context on every identity map of it.
+- (void)indexRecords:(id <NSFastEnumeration>)records inContext:(NSManagedObjectContext *)context {
+    NSDictionary *maps;
+    @synchronized (self) {
+        maps = [[_identityMaps objectForKey:context] copy];
     }
 
-            // Return Data as NSFetchedResultsController
-    else {
+    [maps enumerateKeysAndObjectsUsingBlock:^(NSString *name, NSMapTable *identityMap, BOOL *stop) {
+        [self indexRecords:records onIdentityMap:identityMap named:name];
+    }];
+}
 
-        // Only iPhone.
-#if TARGET_OS_IPHONE
-        return [[NSFetchedResultsController alloc] initWithFetchRequest:request
-                                                   managedObjectContext:self.managedObjectContext
+// Index the records of one Entity by the current value of the key. Faults are skipped, indexing them
+// would fire them. Identity maps are named as "Entity.key".
+- (void)indexRecords:(id <NSFastEnumeration>)records onIdentityMap:(NSMapTable *)identityMap named:(NSString *)name {
+    NSArray *components = [name componentsSeparatedByString:@"."];
+    NSEntityDescription *entity = [self.metadata entity:components[0]];
+    NSString *key = components[1];
+
+    @synchronized (identityMap) {
+        for (NSManagedObject *record in records) {
+            if (![record isKindOfClass:[NSManagedObject class]] || record.isFault || record.isDeleted
+                    || ![record.entity isKindOfEntity:entity])
+                continue;
+
+            id value = [record valueForKey:key];
+            if (value)
+                [identityMap setObject:record forKey:value];
+        }
+    }
+}
+
+// Remove the records of one context from every identity map of it.
+- (void)unindexRecords:(id <NSFastEnumeration>)records inContext:(NSManagedObjectContext *)context {
+    NSDictionary *maps;
+    @synchronized (self) {
+        maps = [[_identityMaps objectForKey:context] copy];
+    }
+
+    [maps enumerateKeysAndObjectsUsingBlock:^(NSString *name, NSMapTable *identityMap, BOOL *stop) {
+        NSString *key = [[name componentsSeparatedByString:@"."] lastObject];
+
+        @synchronized (identityMap) {
+            for (NSManagedObject *record in records) {
+                if (record.isFault)
+                    continue;
+
+                id value = [record valueForKey:key];
+                if (value && [identityMap objectForKey:value] == record)
+                    [identityMap removeObjectForKey:value];
+            }
+        }
+    }];
+}
+
+// Keep the identity maps of one context up to date. This is called on the context queue.
+- (void)contextObjectsDidChange:(NSNotification *)notification {
+    NSManagedObjectContext *context = notification.object;
+    NSDictionary *info = notification.userInfo;
+
+    // The context was reset, every indexed record is gone.
+    if (info[NSInvalidatedAllObjectsKey]) {
+        [self stopIndexingContext:context];
+        return;
+    }
+
+    [self unindexRecords:info[NSDeletedObjectsKey] inContext:context];
+
+    // Changed records are indexed by his new values. Entries left by old values are verified on every hit.
+    [self indexRecords:info[NSInsertedObjectsKey] inContext:context];
+    [self indexRecords:info[NSUpdatedObjectsKey] inContext:context];
+    [self indexRecords:info[NSRefreshedObjectsKey] inContext:context];
+}
+
+// Drop the identity maps of one context, they are created again on the next lookup.
+- (void)stopIndexingContext:(NSManagedObjectContext *)context {
+    [[NSNotificationCenter defaultCenter] removeObserver:self
+                                                    name:NSManagedObjectContextObjectsDidChangeNotification
+                                                  object:context];
+    @synchronized (self) {
+        [_identityMaps removeObjectForKey:context];
+    }
+}
+
+// Drop every identity map.
+- (void)stopIndexingContexts {
+    [[NSNotificationCenter defaultCenter] removeObserver:self
+                                                    name:NSManagedObjectContextObjectsDidChangeNotification
+                                                  object:nil];
+    @synchronized (self) {
+        _identityMaps = nil;
+    }
+}
+
+
+
+#pragma mark - Checking Methods. 
+- (JPDBManagerMetadata *)metadata {
+    JPDBManagerMetadata *metadata = _metadata;
+    if (metadata)
+        return metadata;
+
+    // Wait outside of the lock, the startup takes it when finishing.
+    [self waitForAsyncStartup];
+
+    // Loading the model builds the index, only once when called from many threads.
+    @synchronized (self) {
+        if (_metadata == nil)
+            [self managedObjectModel];
+
+        return _metadata;
+    }
+}
+
+
+// Return the Entity with this name, or mapped to one class with this name.
+- (NSEntityDescription *)entity:(NSString *)entityName {
+    return [self.metadata entity:entityName];
+}
+
+
+// Return YES if specified Entity exist on the model.
+- (BOOL)existEntity:(NSString *)anEntityName {
+    return [self.metadata existEntity:anEntityName];
+}
+
+
+// Return YES if specified Attribute exist on specified Entity.
+- (BOOL)existAttribute:(NSString *)anAttributeName inEntity:(NSString *)anEntityName {
+    return [self.metadata existAttribute:anAttributeName inEntity:anEntityName];
+}
+
+
+
+
+#pragma mark - Database Action Methods.
+
+- (void)checkActionParameters:(JPDBManagerAction *)anAction {
+    [self throwIfNilObject:anAction
+                 withCause:@"Can't perform an Database Action because an Action wasn't passed."];
+
+    [self throwIfNilObject:anAction.entity
+                 withCause:@"Can't perform an Database Action because the 'entity' property isn't setted."];
+
+    // Actions created before the store was opened.
+    if (!anAction.affectedStores)
+        [self routeAction:anAction];
+}
+
+// Build fetch template using...
+- (JPDBManagerAction *)loadFetchTemplateWithAction:(JPDBManagerAction *)anAction {
+
+    // Predicate of the template, still with his variables.
+    NSPredicate *template = [self predicateOfFetchTemplate:anAction.fetchTemplate];
+
+    // Check if exist.
+    [self throwIfNilObject:template
+                 withCause:NSFormatString( @"The Fetch Template '%@' for Entity '%@' doesn't "
+                         @"exist on the Model.", anAction.fetchTemplate, anAction.entityName )];
+
+    // Templates without predicate are cached as NSNull.
+    if ([template isKindOfClass:[NSNull class]])
+        template = nil;
+
+    // Assign the predicate, binding the variables.
+    anAction.predicate = template && [anAction.fetchVariables count] > 0
+            ? [self predicateOfFetchTemplate:anAction.fetchTemplate template:template boundTo:anAction.fetchVariables]
+            : template;
+
+    return anAction;
+}
+
+// Binding copies the whole predicate, so the predicates bound to the same variables are reused.
+- (NSPredicate *)predicateOfFetchTemplate:(NSString *)templateName template:(NSPredicate *)template boundTo:(NSDictionary *)variables {
+    NSMutableDictionary *bound;
+    NSPredicate *predicate;
+
+    @synchronized (self) {
+        if (!_boundFetchTemplates)
+            _boundFetchTemplates = [NSMutableDictionary new];
+
+        bound = _boundFetchTemplates[templateName];
+        if (!bound) {
+            bound = [NSMutableDictionary new];
+            _boundFetchTemplates[templateName] = bound;
+        }
+
+        predicate = bound[variables];
+    }
+
+    if (predicate)
+        return predicate;
+
+    predicate = [template predicateWithSubstitutionVariables:variables];
+
+    @synchronized (self) {
+        // Keep it bounded, many different variables are bound only once anyway.
+        if ([bound count] >= JPDBManagerDefaultFetchTemplateBindings)
+            [bound removeAllObjects];
+
+        bound[[variables copy]] = predicate;
+    }
+
+    return predicate;
+}
+
+// Return the predicate of one Fetch Template, reading the model only on the first time.
+// Predicates are immutable, so the cached one is shared by every action.
+- (id)predicateOfFetchTemplate:(NSString *)templateName {
+    id template;
+
+    @synchronized (self) {
+        if (!_fetchTemplateCache)
+            _fetchTemplateCache = [NSMutableDictionary new];
+
+        template = _fetchTemplateCache[templateName];
+
+        if (template)
+            _fetchTemplateCacheHits++;
+        else
+            _fetchTemplateCacheMisses++;
+    }
+
+    if (template)
+        return template;
+
+    NSFetchRequest *request = [self.managedObjectModel fetchRequestTemplateForName:templateName];
+    if (!request)
+        return nil;
+
+    template = request.predicate ?: [NSNull null];
+
+    @synchronized (self) {
+        _fetchTemplateCache[templateName] = template;
+    }
+
+    return template;
+}
+
+- (NSUInteger)fetchTemplateCacheHits {
+    @synchronized (self) {
+        return _fetchTemplateCacheHits;
+    }
+}
+
+- (NSUInteger)fetchTemplateCacheMisses {
+    @synchronized (self) {
+        return _fetchTemplateCacheMisses;
+    }
+}
+
+- (void)clearFetchTemplateCache {
+    @synchronized (self) {
+        [_fetchTemplateCache removeAllObjects];
+        [_boundFetchTemplates removeAllObjects];
+
+        _fetchTemplateCacheHits = 0;
+        _fetchTemplateCacheMisses = 0;
+    }
+}
+
+
+// This method is called from the JPDBManagerAction as an private call. 
+- (id)performDatabaseActionInternally:(JPDBManagerAction *)request {
+
+    // Check Parameters.
+    [self checkActionParameters:request];
+
+    // Build an query using Fetch template, if defined.
+    if (request.fetchTemplate)
+        request = [self loadFetchTemplateWithAction:request];
+
+    // Execute Fetch.
+    CFAbsoluteTime start = CFAbsoluteTimeGetCurrent();
+    id result = [self runRequest:request];
+
+    BOOL isArray = [result isKindOfClass:[NSArray class]];
+
+    if (self.enableMetrics)
+        [self recordQuery:request
+                fetchType:isArray ? [self fetchTypeOfAction:request] : JPDBManagerMetricFetchController
+                 duration:CFAbsoluteTimeGetCurrent() - start
+                     rows:isArray ? [result count] : 0];
+
+    if (isArray && !request.returnsDictionaries) {
+        NSManagedObjectContext *context = [self contextForAction:request];
+
+        // Fetched records are found by key without querying again.
+        [self indexRecords:result inContext:context];
+
+        // Objects fetched on the main context stay registered on him.
+        if (context == _managedObjectContext)
+            [self governMemoryOfRecords:result];
+    }
+
+    return result;
+}
+
+// Count the records matched by an action on the persistent store, without creating any object.
+- (NSNumber *)countWithAction:(JPDBManagerAction *)request {
+
+    // Check Parameters.
+    [self checkActionParameters:request];
+
+    // Build an query using Fetch template, if defined.
+    if (request.fetchTemplate)
+        request = [self loadFetchTemplateWithAction:request];
+
+    // Error Control.
+    NSError *error = nil;
+
+    // Execute the Count.
+    CFAbsoluteTime start = CFAbsoluteTimeGetCurrent();
+    NSUInteger count = [[self contextForAction:request] countForFetchRequest:request error:&error];
+
+    if (self.enableMetrics)
+        [self recordQuery:request
+                fetchType:JPDBManagerMetricFetchCount
+                 duration:CFAbsoluteTimeGetCurrent() - start
+                     rows:count == NSNotFound ? 0 : count];
+
+    // Notificate the error.
+    if (count == NSNotFound) {
+        if (error)
+            [self notificateError:error];
+        count = 0;
+    }
+
+    return @(count);
+}
+
+- (id)runRequest:(JPDBManagerAction *)request {
+
+    // Return Data as Arrays.
+    if (request.returnActionAsArray) {
+        NSManagedObjectContext *context = [self contextForAction:request];
+
+        // Unsaved changes aren't on the cached results.
+        JPDBManagerQueryCache *cache = [context hasChanges] ? nil : self.queryCache;
+        id cacheKey = [cache keyForRequest:request];
+
+        // Answer from the cache.
+        NSArray *objectIDs = [cache objectIDsForKey:cacheKey];
+        NSArray *cachedResult = objectIDs ? [self recordsWithObjectIDs:objectIDs ofRequest:request inContext:context] : nil;
+        if (cachedResult)
+            return cachedResult;
+
+        // Error Control.
+        NSError *error = nil;
+
+        // Execute the Fetch Requester.
+        id queryResult = [context executeFetchRequest:request
+                                                error:&error];
+
+        // Notificate the error.
+        if (error)
+            [self notificateError:error];
+
+        // Store on the cache.
+        [cache storeObjects:queryResult forKey:cacheKey];
+
+        // Return data.
+        return queryResult;
+    }
+
+            // Return Data as NSFetchedResultsController
+    else {
+
+        // Only iPhone.
+#if TARGET_OS_IPHONE
+        return [[NSFetchedResultsController alloc] initWithFetchRequest:request
+                                                   managedObjectContext:[self contextForAction:request]
                                                      sectionNameKeyPath:nil
                                                               cacheName:nil];
 #else
@@ -416,30 +1289,324 @@
 
 
 
+#pragma mark - Group Commit Methods.
+
+- (void)setEnableGroupCommit:(BOOL)newValue {
+    if (_enableGroupCommit == newValue)
+        return;
+
+    _enableGroupCommit = newValue;
+
+    // Don't leave writes behind when the application can be killed.
+    NSNotificationCenter *center = [NSNotificationCenter defaultCenter];
+    for (NSString *name in @[UIApplicationDidEnterBackgroundNotification, UIApplicationWillTerminateNotification]) {
+        if (newValue)
+            [center addObserver:self selector:@selector(flushOnBackground:) name:name object:nil];
+        else
+            [center removeObserver:self name:name object:nil];
+    }
+
+    // Save what was waiting.
+    if (!newValue)
+        [self flush];
+}
+
+// Commit requested by one action. This is a private call.
+- (void)scheduleCommit {
+    // The transaction commits once when it finishes.
+    if ([self isInTransactionOfCurrentThread])
+        return;
+
+    if (!self.enableGroupCommit) {
+        [self commit];
+        return;
+    }
+
+    BOOL flushNow = NO;
+    NSUInteger generation = 0;
+    BOOL schedule = NO;
+
+    @synchronized (self) {
+        _pendingWrites++;
+
+        if (_pendingWrites >= (self.groupCommitThreshold ?: JPDBManagerDefaultGroupCommitThreshold)) {
+            flushNow = YES;
+        }
+        else if (!_groupCommitScheduled) {
+            _groupCommitScheduled = schedule = YES;
+            generation = _groupCommitGeneration;
+        }
+    }
+
+    if (flushNow) {
+        [self commitPendingWrites];
+    }
+    else if (schedule) {
+        NSTimeInterval interval = self.groupCommitInterval ?: JPDBManagerDefaultGroupCommitInterval;
+
+        // The main context lives on the main thread.
+        dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t) (interval * NSEC_PER_SEC)), dispatch_get_main_queue(), ^{
+            @synchronized (self) {
+                // Already saved by the threshold or by one flush.
+                if (generation != _groupCommitGeneration)
+                    return;
+            }
+            [self commitPendingWrites];
+        });
+    }
+}
+
+// Take the pending writes and save them. Return how many writes were absorbed.
+- (NSUInteger)takePendingWrites {
+    @synchronized (self) {
+        NSUInteger writes = _pendingWrites;
+
+        _pendingWrites = 0;
+        _groupCommitScheduled = NO;
+        _groupCommitGeneration++;
+
+        if (writes > 0) {
+            _lastGroupCommitWrites = writes;
+            _groupCommits++;
+            _groupCommitWrites += writes;
+        }
+
+        return writes;
+    }
+}
+
+- (void)commitPendingWrites {
+    if ([self takePendingWrites] > 0)
+        [self commit];
+}
+
+- (void)flush {
+    [self commitAndWait];
+}
+
+- (void)flushOnBackground:(NSNotification *)notification {
+    UIApplication *application = [UIApplication sharedApplication];
+
+    // Ask for some time to finish the save.
+    __block UIBackgroundTaskIdentifier task = [application beginBackgroundTaskWithExpirationHandler:^{
+        [application endBackgroundTask:task];
+        task = UIBackgroundTaskInvalid;
+    }];
+
+    [self flush];
+
+    if (task != UIBackgroundTaskInvalid)
+        [application endBackgroundTask:task];
+}
+
+
+
+
+#pragma mark - Memory Governor Methods.
+
+- (void)setEnableMemoryGovernor:(BOOL)newValue {
+    if (_enableMemoryGovernor == newValue)
+        return;
+
+    _enableMemoryGovernor = newValue;
+
+    NSNotificationCenter *center = [NSNotificationCenter defaultCenter];
+    if (newValue)
+        [center addObserver:self selector:@selector(collectMemoryOnWarning:)
+                       name:UIApplicationDidReceiveMemoryWarningNotification object:nil];
+    else
+        [center removeObserver:self name:UIApplicationDidReceiveMemoryWarningNotification object:nil];
+}
+
+// Some records were registered on the main context. They're still being returned to the caller, so the
+// collection runs on the next turn of the main queue and spares them.
+- (void)governMemoryOfRecords:(NSArray *)records {
+    if (!self.enableMemoryGovernor)
+        return;
+
+    JPDBManagerMemoryGovernor *governor = self.memoryGovernor;
+    if (![governor noteRegisteredObjects:[records count]])
+        return;
+
+    @synchronized (self) {
+        // One collection is already coming, it spares these records too.
+        if (_sparedRecords) {
+            [_sparedRecords addObjectsFromArray:records];
+            return;
+        }
+        _sparedRecords = [records mutableCopy];
+    }
+
+    dispatch_async(dispatch_get_main_queue(), ^{
+        NSArray *spared;
+        @synchronized (self) {
+            spared = _sparedRecords;
+            _sparedRecords = nil;
+        }
+
+        [self didCollectMemory:[governor collectIfNeededSparing:spared]];
+    });
+}
+
+- (void)collectMemoryOnWarning:(NSNotification *)notification {
+    [self didCollectMemory:[self.memoryGovernor collect]];
+}
+
+// The records indexed by key became invalid if the context was reset.
+- (void)didCollectMemory:(NSDictionary *)collection {
+    if (![collection[JPDBManagerMemoryReset] boolValue])
+        return;
+
+    [self stopIndexingContext:_managedObjectContext];
+}
+
+
+
+
+#pragma mark - Metrics Methods.
+
+- (NSString *)fetchTypeOfAction:(JPDBManagerAction *)anAction {
+    switch (anAction.resultType) {
+        case NSManagedObjectIDResultType:
+            return JPDBManagerMetricFetchObjectIDs;
+        case NSDictionaryResultType:
+            return JPDBManagerMetricFetchDictionaries;
+        case NSCountResultType:
+            return JPDBManagerMetricFetchCount;
+        default:
+            return JPDBManagerMetricFetchObjects;
+    }
+}
+
+- (void)recordQuery:(JPDBManagerAction *)anAction fetchType:(NSString *)fetchType duration:(NSTimeInterval)duration rows:(NSUInteger)rows {
+    NSMutableDictionary *event = [NSMutableDictionary dictionaryWithCapacity:6];
+    event[JPDBManagerMetricEntity] = anAction.entityName ?: @"";
+    event[JPDBManagerMetricFetchType] = fetchType;
+    event[JPDBManagerMetricDuration] = @(duration);
+    event[JPDBManagerMetricRows] = @(rows);
+    event[JPDBManagerMetricDate] = [NSDate date];
+    if (anAction.fetchTemplate)
+        event[JPDBManagerMetricTemplate] = anAction.fetchTemplate;
+
+    [self.metrics recordQuery:event];
+
+    id <JPDBManagerMetricsDelegate> delegate = self.metricsDelegate;
+    if ([delegate respondsToSelector:@selector(databaseManager:didPerformQuery:)])
+        [delegate databaseManager:self didPerformQuery:event];
+}
+
+
+
+
 #pragma mark - Write Data Methods.
 
 // Commit all pendent operations to the persistent store.
 - (void)commit {
+    [self commitWithCompletion:nil];
+}
+
+- (void)commitWithCompletion:(void (^)(NSError *error))completion {
+
+    // Push the changes of the main context, this write to the disk if there's no writer context.
+    NSError *anError = [self commitMainContext];
+
+    if (anError || !_writerContext) {
+        if (completion)
+            completion(anError);
+        return;
+    }
+
+    // Persist to the disk on background.
+    NSManagedObjectContext *writer = _writerContext;
+    [writer performBlock:^{
+        NSError *writeError = [self commitWriterContext:writer];
+
+        if (completion) {
+            dispatch_async(dispatch_get_main_queue(), ^{
+                completion(writeError);
+            });
+        }
+    }];
+}
+
+- (void)commitAndWait {
+
+    // Push the changes of the main context, this write to the disk if there's no writer context.
+    if ([self commitMainContext] || !_writerContext)
+        return;
+
+    // Wait the writer context persist this changes, and any previous commit queued before them.
+    NSManagedObjectContext *writer = _writerContext;
+    [writer performBlockAndWait:^{
+        [self commitWriterContext:writer];
+    }];
+}
+
+// Commit the main context. Return the error, if any.
+- (NSError *)commitMainContext {
 
     // We need to have the full environment working to commit.
-    if (_managedObjectModel && _managedObjectContext && _persistentStoreCoordinator) {
+    if (!(_managedObjectModel && _managedObjectContext && _persistentStoreCoordinator))
+        return nil;
 
-        NSLog(@"Saving Changes To Database.");
+    // Inside one transaction, everything is committed when the outermost transaction finishes.
+    // Commits of other threads wait for it, so they don't save half of his changes.
+    if ([self waitForTransactionOfOtherThread])
+        return nil;
 
-        // Error Control.
-        NSError *anError = nil;
+    // Every save of the main context also saves the writes waiting for the group commit.
+    [self takePendingWrites];
+
+    // Error Control.
+    __block NSError *anError = nil;
+    __block BOOL saved = YES;
+
+    NSManagedObjectContext *context = _managedObjectContext;
+
+    //// //// //// //// //// //// //// /////// //// //// //// //// //// //// ///
+    // Performs the commit action for the application, which is to send
+    // the save: message to the Application's Managed Object Context.
+    void (^save)(void) = ^{
+        saved = [self saveContext:context error:&anError];
+    };
+
+    // Queue based main context should be saved on his own queue.
+    if (context.concurrencyType == NSConfinementConcurrencyType)
+        save();
+    else
+        [context performBlockAndWait:save];
+
+    if (!saved) {
+        //Warn( @"Commit Error: %@.\n\n. Full Error Description:\n\n %@", [anError localizedDescription], anError );
+        NSLog(@"Commit Error: %@.\n\n. Full Error Description:\n\n %@", [anError localizedDescription], anError);
+
+        // Notificate the error.
+        [self notificateError:anError];
+        return anError;
+    }
 
-        //// //// //// //// //// //// //// /////// //// //// //// //// //// //// ///
-        // Performs the commit action for the application, which is to send
-        // the save: message to the Application's Managed Object Context.
-        if (![[self managedObjectContext] save:&anError]) {
-            //Warn( @"Commit Error: %@.\n\n. Full Error Description:\n\n %@", [anError localizedDescription], anError );
-            NSLog(@"Commit Error: %@.\n\n. Full Error Description:\n\n %@", [anError localizedDescription], anError);
+    return nil;
+}
+
+// Commit the writer context to the disk. This is called on the writer context queue.
+- (NSError *)commitWriterContext:(NSManagedObjectContext *)writer {
+    if (![writer hasChanges])
+        return nil;
 
-            // Notificate the error.
+    // Error Control.
+    NSError *anError = nil;
+
+    if (![self saveContext:writer error:&anError]) {
+        NSLog(@"Commit Error: %@.\n\n. Full Error Description:\n\n %@", [anError localizedDescription], anError);
+
+        // Notificate the error on the main thread, as every other notification.
+        dispatch_async(dispatch_get_main_queue(), ^{
             [self notificateError:anError];
-        }
+        });
+        return anError;
     }
+
+    return nil;
 }
 
 
@@ -447,22 +1614,519 @@
 - (id)createNewRecordFromAction:(JPDBManagerAction *)anAction {
 
     // Create and return a new record or nil if the entity doesn't exist.
-    return ![self existEntity:anAction.entityName]
+    if (![self existEntity:anAction.entityName])
+        return nil;
+
+    NSManagedObjectContext *context = [self contextForAction:anAction];
+    id record = [NSEntityDescription insertNewObjectForEntityForName:anAction.entityName inManagedObjectContext:context];
+
+    // Save it on the partition of his Entity.
+    NSPersistentStore *store = [self persistentStoreForEntity:anAction.entityName];
+    if (store)
+        [context assignObject:record toPersistentStore:store];
+
+    if (context == _managedObjectContext)
+        [self governMemoryOfRecords:@[record]];
 
-            ? nil
-            : [NSEntityDescription insertNewObjectForEntityForName:anAction.entityName
-                                            inManagedObjectContext:self.managedObjectContext];
+    return record;
 
 }
 
 
 
 
+#pragma mark - Partition Methods.
+- (void)addPartition:(NSString *)anName entities:(NSArray *)entityNames configuration:(JPDBManagerStoreConfiguration *)anConfiguration {
+    if (_persistentStoreCoordinator)
+        [NSException raise:JPDBManagerStartException
+                    format:@"The partition '%@' should be added before starting the Core Data.", anName];
+
+    @synchronized (self) {
+        if (!_partitionConfigurations) {
+            _partitionConfigurations = [NSMutableDictionary dictionary];
+            _partitionEntities = [NSMutableDictionary dictionary];
+        }
+
+        _partitionConfigurations[anName] = anConfiguration ? [anConfiguration copy] : [JPDBManagerStoreConfiguration init];
+        if (entityNames)
+            _partitionEntities[anName] = [entityNames copy];
+    }
+}
+
+- (NSArray *)partitions {
+    @synchronized (self) {
+        return [[_partitionConfigurations allKeys] sortedArrayUsingSelector:@selector(compare:)];
+    }
+}
+
+- (NSPersistentStore *)persistentStoreOfPartition:(NSString *)anName {
+    for (NSPersistentStore *store in [_persistentStoreCoordinator persistentStores]) {
+        if ([store.configurationName isEqualToString:anName])
+            return store;
+    }
+    return nil;
+}
+
+- (NSPersistentStore *)persistentStoreForEntity:(NSString *)anEntityName {
+    if (!_partitionOfEntity)
+        return nil;
+
+    return [self persistentStoreOfPartition:_partitionOfEntity[anEntityName] ?: JPDBManagerDefaultPartition];
+}
+
+// Limit the fetches of one action to the store of his Entity.
+- (void)routeAction:(JPDBManagerAction *)anAction {
+    NSPersistentStore *store = [self persistentStoreForEntity:anAction.entityName];
+    if (store)
+        anAction.affectedStores = @[store];
+}
+
+// Where the store of one partition is located, nil for in-memory stores.
+- (NSURL *)storeURLOfPartition:(NSString *)anName {
+    JPDBManagerStoreConfiguration *configuration = _partitionConfigurations[anName];
+
+    if ([configuration.storeType isEqualToString:NSInMemoryStoreType])
+        return nil;
+
+    if (configuration.storeURL)
+        return configuration.storeURL;
+
+    // Next to the main store: mainDatabase-partition.SQlite
+    NSURL *main = [self SQLiteFilePath];
+    NSString *file = NSFormatString( @"%@-%@.%@", [[main URLByDeletingPathExtension] lastPathComponent], anName, [main pathExtension] );
+
+    return [[main URLByDeletingLastPathComponent] URLByAppendingPathComponent:file];
+}
+
+- (BOOL)addStoreOfPartition:(NSString *)anName toCoordinator:(NSPersistentStoreCoordinator *)coordinator error:(NSError **)error {
+    JPDBManagerStoreConfiguration *configuration = _partitionConfigurations[anName];
+
+    return [coordinator addPersistentStoreWithType:configuration.storeType
+                                     configuration:anName
+                                               URL:[self storeURLOfPartition:anName]
+                                           options:[configuration storeOptions]
+                                             error:error] != nil;
+}
+
+// Set the Entities of every partition as model configurations, the remaining ones go to the main store.
+// Return NO if there's no partition. Called before the coordinator opens any store.
+- (BOOL)applyPartitionsToModel:(NSManagedObjectModel *)anModel {
+    NSArray *partitions = [self partitions];
+    if ([partitions count] == 0)
+        return NO;
+
+    NSMutableDictionary *partitionOfEntity = [NSMutableDictionary dictionary];
+
+    for (NSString *partition in partitions) {
+        NSArray *names = _partitionEntities[partition];
+        NSMutableArray *entities = [NSMutableArray array];
+
+        // Defined on the model.
+        if (!names)
+            names = [[anModel entitiesForConfiguration:partition] valueForKey:@"name"];
+
+        for (NSString *name in names) {
+            NSEntityDescription *entity = [self.metadata entity:name];
+            [self throwIfNilObject:entity
+                         withCause:NSFormatString( @"The Entity '%@' of the partition '%@' doesn't exist on the Model.", name, partition )];
+
+            // The entity and all his sub entities.
+            NSMutableArray *pending = [NSMutableArray arrayWithObject:entity];
+            while ([pending count] > 0) {
+                NSEntityDescription *next = [pending lastObject];
+                [pending removeLastObject];
+
+                if (partitionOfEntity[next.name])
+                    continue;
+
+                partitionOfEntity[next.name] = partition;
+                [entities addObject:next];
+                [pending addObjectsFromArray:next.subentities];
+            }
+        }
+
+        [self setEntities:entities forConfiguration:partition ofModel:anModel];
+    }
+
+    NSMutableArray *remaining = [NSMutableArray array];
+    for (NSEntityDescription *entity in [anModel entities]) {
+        if (!partitionOfEntity[entity.name])
+            [remaining addObject:entity];
+    }
+    [self setEntities:remaining forConfiguration:JPDBManagerDefaultPartition ofModel:anModel];
+
+    _partitionOfEntity = [partitionOfEntity copy];
+    return YES;
+}
+
+// Models already used by one coordinator are immutable. When the Core Data is started again with
+// the same model his configurations are already set, so they're only changed when needed.
+- (void)setEntities:(NSArray *)entities forConfiguration:(NSString *)configuration ofModel:(NSManagedObjectModel *)anModel {
+    NSSet *current = [NSSet setWithArray:[[anModel entitiesForConfiguration:configuration] valueForKey:@"name"]];
+
+    if (![current isEqualToSet:[NSSet setWithArray:[entities valueForKey:@"name"]]])
+        [anModel setEntities:entities forConfiguration:configuration];
+}
+
+- (BOOL)resetPartition:(NSString *)anName error:(NSError **)error {
+    NSPersistentStore *store = [self persistentStoreOfPartition:anName];
+    if (!store)
+        return NO;
+
+    ////// ////// //////
+    // Nobody can hold objects of the dropped store.
+    [_contextPool waitUntilAllBlocksAreFinished];
+    for (NSManagedObjectContext *context in _contextPool.contexts) {
+        [context performBlockAndWait:^{
+            [context reset];
+        }];
+    }
+
+    // Queue based main context should be reset on his own queue.
+    NSManagedObjectContext *mainContext = _managedObjectContext;
+    if (mainContext.concurrencyType == NSConfinementConcurrencyType)
+        [mainContext reset];
+    else
+        [mainContext performBlockAndWait:^{
+            [mainContext reset];
+        }];
+
+    [_writerContext performBlockAndWait:^{
+        [_writerContext reset];
+    }];
+
+    [self stopIndexingContexts];
+    [_queryCache removeAllResults];
+
+    ////// ////// //////
+    // Destroy and recreate.
+    if (![_persistentStoreCoordinator removePersistentStore:store error:error])
+        return NO;
+
+    NSURL *storeURL = [self storeURLOfPartition:anName];
+    if (storeURL) {
+        // The store and his journal files.
+        for (NSString *suffix in @[@"", @"-wal", @"-shm"]) {
+            NSURL *file = [NSURL fileURLWithPath:[[storeURL path] stringByAppendingString:suffix]];
+            [[NSFileManager defaultManager] removeItemAtURL:file error:NULL];
+        }
+    }
+
+    return [self addStoreOfPartition:anName toCoordinator:_persistentStoreCoordinator error:error];
+}
+
+
+
+
+#pragma mark - Transaction Methods.
+- (BOOL)inTransaction {
+    NSCondition *condition = self.transactionCondition;
+
+    [condition lock];
+    BOOL inTransaction = _transactionDepth > 0;
+    [condition unlock];
+
+    return inTransaction;
+}
+
+// Created on the first use.
+- (NSCondition *)transactionCondition {
+    @synchronized (self) {
+        if (!_transactionCondition)
+            _transactionCondition = [NSCondition new];
+    }
+    return _transactionCondition;
+}
+
+// YES if the current thread is running one transaction.
+- (BOOL)isInTransactionOfCurrentThread {
+    NSCondition *condition = self.transactionCondition;
+
+    [condition lock];
+    BOOL inTransaction = _transactionDepth > 0 && _transactionThread == [NSThread currentThread];
+    [condition unlock];
+
+    return inTransaction;
+}
+
+// Block until the transaction of other thread finishes. Return YES if the current thread is running one transaction.
+- (BOOL)waitForTransactionOfOtherThread {
+    NSCondition *condition = self.transactionCondition;
+
+    [condition lock];
+    while (_transactionDepth > 0 && _transactionThread != [NSThread currentThread])
+        [condition wait];
+    BOOL inTransaction = _transactionDepth > 0;
+    [condition unlock];
+
+    return inTransaction;
+}
+
+- (void)enterTransaction {
+    NSCondition *condition = self.transactionCondition;
+
+    [condition lock];
+    if (_transactionDepth++ == 0)
+        _transactionThread = [NSThread currentThread];
+    [condition unlock];
+}
+
+- (void)leaveTransaction {
+    NSCondition *condition = self.transactionCondition;
+
+    [condition lock];
+    if (--_transactionDepth == 0) {
+        _transactionThread = nil;
+        [condition broadcast];
+    }
+    [condition unlock];
+}
+
+- (BOOL)performTransaction:(BOOL (^)(NSError **error))block {
+    NSManagedObjectContext *context = self.managedObjectContext;
+
+    __block BOOL success = NO;
+    __block NSError *anError = nil;
+    __block NSException *anException = nil;
+
+    void (^transaction)(void) = ^{
+        @try {
+            success = [self runTransaction:block inContext:context error:&anError];
+        }
+        @catch (NSException *exception) {
+            anException = exception;
+        }
+    };
+
+    // Queue based main context should be used on his own queue.
+    if (context.concurrencyType == NSConfinementConcurrencyType)
+        transaction();
+    else
+        [context performBlockAndWait:transaction];
+
+    // Exceptions doesn't cross the context queue, raise them here.
+    if (anException)
+        @throw anException;
+
+    if (!success) {
+        if (anError)
+            [self notificateError:anError];
+        return NO;
+    }
+
+    // Persist the outermost transaction to the disk.
+    if (!self.inTransaction && _writerContext) {
+        NSManagedObjectContext *writer = _writerContext;
+        [writer performBlock:^{
+            [self commitWriterContext:writer];
+        }];
+    }
+
+    return YES;
+}
+
+// Run one transaction level. Every level is one undo group, so one nested transaction
+// can be rolled back without losing the changes of the outer ones. This is called on the main context queue.
+- (BOOL)runTransaction:(BOOL (^)(NSError **error))block inContext:(NSManagedObjectContext *)context error:(NSError **)error {
+    BOOL outermost = ![self isInTransactionOfCurrentThread];
+
+    // Changes are only undoable with an undo manager, create one while the transaction runs.
+    if (outermost && !context.undoManager) {
+        NSUndoManager *undoManager = [NSUndoManager new];
+        undoManager.groupsByEvent = NO;
+        context.undoManager = undoManager;
+        _transactionOwnsUndoManager = YES;
+    }
+
+    NSUndoManager *undoManager = context.undoManager;
+    BOOL success = NO;
+
+    [context processPendingChanges];
+    [undoManager beginUndoGrouping];
+    [self enterTransaction];
+
+    @try {
+        success = block(error);
+    }
+    @finally {
+        [context processPendingChanges];
+        [undoManager endUndoGrouping];
+        [self leaveTransaction];
+
+        // Roll back this level only. On exceptions too, before they go on.
+        if (!success)
+            [undoManager undoNestedGroup];
+
+        // Commit once.
+        if (success && outermost) {
+            NSError *commitError = [self commitMainContext];
+            if (commitError) {
+                [undoManager undo];
+                if (error)
+                    *error = commitError;
+                success = NO;
+            }
+        }
+
+        if (outermost && _transactionOwnsUndoManager) {
+            context.undoManager = nil;
+            _transactionOwnsUndoManager = NO;
+        }
+    }
+
+    return success;
+}
+
+
+
+
+#pragma mark - Concurrency Methods.
+- (void)performBlock:(void (^)(NSManagedObjectContext *context))block {
+    [self.contextPool performBlock:^(NSManagedObjectContext *context) {
+        block(context);
+        [self commitContext:context];
+    }];
+}
+
+- (void)performBlockAndWait:(void (^)(NSManagedObjectContext *context))block {
+    [self.contextPool performBlockAndWait:^(NSManagedObjectContext *context) {
+        block(context);
+        [self commitContext:context];
+    }];
+}
+
+// Commit one context of the pool. This is called on the context queue.
+- (void)commitContext:(NSManagedObjectContext *)context {
+    if (![context hasChanges])
+        return;
+
+    // Error Control.
+    NSError *anError = nil;
+
+    if (![self saveContext:context error:&anError])
+        [self notificateError:anError];
+}
+
+// Save one context, recording the commit if the metrics are enabled. This is called on the context queue.
+- (BOOL)saveContext:(NSManagedObjectContext *)context error:(NSError **)error {
+    if (!self.enableMetrics)
+        return [context save:error];
+
+    NSUInteger inserted = [[context insertedObjects] count];
+    NSUInteger updated = [[context updatedObjects] count];
+    NSUInteger deleted = [[context deletedObjects] count];
+
+    CFAbsoluteTime start = CFAbsoluteTimeGetCurrent();
+    BOOL saved = [context save:error];
+
+    NSDictionary *event = @{
+            JPDBManagerMetricDuration : @(CFAbsoluteTimeGetCurrent() - start),
+            JPDBManagerMetricInserted : @(inserted),
+            JPDBManagerMetricUpdated  : @(updated),
+            JPDBManagerMetricDeleted  : @(deleted),
+            JPDBManagerMetricDate     : [NSDate date]
+    };
+
+    [self.metrics recordCommit:event];
+
+    id <JPDBManagerMetricsDelegate> delegate = self.metricsDelegate;
+    if ([delegate respondsToSelector:@selector(databaseManager:didCommit:)])
+        [delegate databaseManager:self didCommit:event];
+
+    return saved;
+}
+
+// Start to merge the changes committed on this context on every other context.
+- (void)observeSavesOfContext:(NSManagedObjectContext *)context {
+    [[NSNotificationCenter defaultCenter] addObserver:self
+                                             selector:@selector(contextDidSave:)
+                                                 name:NSManagedObjectContextDidSaveNotification
+                                               object:context];
+}
+
+- (void)contextDidSave:(NSNotification *)notification {
+    NSManagedObjectContext *writer = _writerContext;
+    NSManagedObjectContext *main = _managedObjectContext;
+
+    // Saves of the pool also go to the writer context first, otherwise he keeps stale snapshots and his
+    // next save would write them back. The main context is his child, so he merges after him.
+    if (writer && notification.object != main && notification.object != writer) {
+        [writer performBlock:^{
+            [writer mergeChangesFromContextDidSaveNotification:notification];
+
+            if (main)
+                [self mergeChanges:notification intoContext:main];
+        }];
+    }
+
+    // Merge on the main context. The writer context only have changes that came from him.
+    else if (notification.object != main && notification.object != writer && main)
+        [self mergeChanges:notification intoContext:main];
+
+    // Merge on the pool.
+    [_contextPool mergeChangesFromContextDidSaveNotification:notification];
+}
+
+- (void)mergeChanges:(NSNotification *)notification intoContext:(NSManagedObjectContext *)context {
+
+    // Queue based contexts merge on his own queue.
+    if (context.concurrencyType != NSConfinementConcurrencyType) {
+        [context performBlock:^{
+            [context mergeChangesFromContextDidSaveNotification:notification];
+        }];
+    }
+
+    // The thread safe context remap the call to his thread by itself.
+    else if ([NSThread isMainThread] || [context isKindOfClass:[IAThreadSafeContext class]]) {
+        [context mergeChangesFromContextDidSaveNotification:notification];
+    }
+
+    // Confined main context lives on the main thread.
+    else {
+        dispatch_async(dispatch_get_main_queue(), ^{
+            [context mergeChangesFromContextDidSaveNotification:notification];
+        });
+    }
+}
+
+
+
+
+#pragma mark - Memory Methods.
+
+// Turn the records back into faults, releasing his row data. Records with unsaved changes are kept untouched.
+- (void)refaultRecords:(NSArray *)records {
+    for (NSManagedObject *record in records) {
+        if (![record isFault] && ![record hasChanges])
+            [[record managedObjectContext] refreshObject:record mergeChanges:NO];
+    }
+}
+
+
+
+
 #pragma mark -  Remove Data Methods.
 
 // Delete an record of database. Use the Default Setting to Commit Automatically decision.
 - (void)deleteRecord:(id)anObject {
-    [self.managedObjectContext deleteObject:anObject];
+    NSManagedObjectContext *context = [anObject managedObjectContext];
+
+    // Records not yet inserted on any context are deleted from the main context.
+    if (!context)
+        context = self.managedObjectContext;
+
+    [context deleteObject:anObject];
+}
+
+// Delete the records of the informed Object IDs without loading them, on the context of the action.
+- (void)deleteRecordsWithIDs:(NSArray *)objectIDs fromAction:(JPDBManagerAction *)anAction {
+    NSManagedObjectContext *context = [self contextForAction:anAction];
+
+    for (NSManagedObjectID *objectID in objectIDs)
+        [context deleteObject:[context objectWithID:objectID]];
+
+    // Apply the delete rules (cascades, nullify...) of this batch now.
+    [context processPendingChanges];
 }
 
 @end
@@ -38,6 +38,27 @@
 
 
 @class JPDBManager;
+@class JPDBManagerAsyncQuery;
+@class JPDBManagerCursor;
+
+/**
+ * Block called for every batch of records enumerated by an \link JPDBManagerAction Database Action\endlink.
+ * Set <tt>*stop</tt> to <b>YES</b> to stop the enumeration after the current batch.
+ */
+typedef void (^JPDBManagerBatchBlock)(NSArray *batch, BOOL *stop);
+
+/**
+ * Block called after every batch of records imported by an \link JPDBManagerAction Database Action\endlink.
+ * Receive how many records was imported until now and the throughput in records per second.
+ * Set <tt>*stop</tt> to <b>YES</b> to stop the import after the current batch.
+ */
+typedef void (^JPDBManagerImportProgressBlock)(NSUInteger importedCount, double recordsPerSecond, BOOL *stop);
+
+/**
+ * Block called with the records queried on background by an \link JPDBManagerAction Database Action\endlink.
+ * Receive <tt>nil</tt> if the query failed, the error is notified as any other error. See \ref errors.
+ */
+typedef void (^JPDBManagerQueryBlock)(NSArray *result);
 
 /**
  \class JPDBManagerAction
@@ -98,6 +119,9 @@
 /// Values to replace on the pre formatted Fetch Template.
 @property(readonly) NSMutableDictionary* fetchVariables;
 
+/// Map the keys of imported dictionaries to Attribute names. See #importRecords:.
+@property(readonly) NSDictionary* importKeyMap;
+
 
 /**
  * Set if the Manager should commit this transaction immediately or not.<br>
@@ -119,11 +143,44 @@
  */
 @property(assign) BOOL returnActionAsArray;
 
+/**
+ * Set if the records should be returned as <b>NSDictionary</b> objects instead of Managed Objects.
+ * Dictionaries only hold the #applyPropertiesToFetch: properties, so they are much lighter to fetch and keep.
+ * Combine with <b>returnsDistinctResults</b> to remove duplicated dictionaries.<br>
+ * Default value is <b>NO</b>.
+ */
+@property(assign, nonatomic) BOOL returnsDictionaries;
+
 /**
  * Instance of the Manager to perform this Database Action.
  */
 @property(weak) JPDBManager *manager;
 
+/**
+ * Context to perform this Database Action. When <tt>nil</tt> the main context of the #manager is used.
+ * See JPDBManager::getDatabaseActionForEntity:inContext:.
+ */
+@property(weak) NSManagedObjectContext *context;
+
+/**
+ * How many faults were fired by the records returned by this action: records that were faults and
+ * Relationships that weren't prefetched. Only counted when #setFaultCountingEnabled: is set, use it
+ * on debug builds and tests to find N+1 queries. See #applyPrefetchRelationships:.
+ */
+@property(readonly) NSUInteger faultsFired;
+
+/**
+ * Enable or disable the fault counting of every action, see #faultsFired.
+ * Counting hooks every property access of the Managed Objects, so keep it disabled on release builds.<br>
+ * Default value is <b>NO</b>.
+ */
++ (void)setFaultCountingEnabled:(BOOL)enabled;
+
+/**
+ * <b>YES</b> if the fault counting is enabled. See #setFaultCountingEnabled:.
+ */
++ (BOOL)isFaultCountingEnabled;
+
 
 //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// 
 #pragma mark -
@@ -144,6 +201,20 @@
  */
 -(void)resetFetchLimits;
 
+/**
+ * Query the next page of records after the position of one cursor and move the cursor after it.
+ * Pages are selected by the sort key values of the last record read instead of an offset, so deep pages are as
+ * fast as the first one. See JPDBManagerCursor for the requirements on the sort keys.
+ * \code
+ * JPDBManagerCursor *cursor = [JPDBManagerCursor initWithPageSize:50];
+ * NSArray *page = [[action applySortDescriptors:sorters] nextPageAfterCursor:cursor];
+ * \endcode
+ * @param cursor The cursor, positioned before the first page to start.
+ * @return The records of the page. Empty when there's no more pages.
+ * @throw An  \ref JPDBManagerActionException  exception if this action has no sort descriptors or use an Fetch Template.
+ */
+-(NSArray *)nextPageAfterCursor:(JPDBManagerCursor *)cursor;
+
 /**
  * Reset this Action Settings to default values.
  */
@@ -184,6 +255,14 @@
  */
 -(id)applyFetchVariables:(NSDictionary*)anDictionary;
 
+/**
+ * Set how the keys of imported dictionaries map to Attribute names of the Entity.
+ * Keys that aren't mapped are used as Attribute names.
+ * @param anDictionary An Dictionary with imported Keys and Attribute names as Values.
+ * @return Return itself.
+ */
+-(id)applyImportKeyMap:(NSDictionary*)anDictionary;
+
 /**
  * Deprecated you should use 'applyFetchVariables:' instead.
  */
@@ -194,6 +273,32 @@
  */
 -(instancetype)applyPredicate:(NSPredicate*)anPredicate;
 
+/**
+ * Fetch only some properties of the Entity, returning the records as dictionaries. See #returnsDictionaries.
+ * @param listOfKeys An Array of Attribute names, to-one Relationship names or key paths.
+ * @return Return itself.
+ * @throw An  \ref JPDBManagerActionException  exception if some property doesn't exist on the Entity.
+ */
+-(instancetype)applyPropertiesToFetch:(NSArray*)listOfKeys;
+
+/**
+ * Group the dictionaries returned by this action by some properties. See #returnsDictionaries.
+ * Every property fetched must be grouped or be an aggregate expression.
+ * @param listOfKeys An Array of Attribute names or key paths.
+ * @return Return itself.
+ * @throw An  \ref JPDBManagerActionException  exception if some property doesn't exist on the Entity.
+ */
+-(instancetype)applyGroupBy:(NSArray*)listOfKeys;
+
+/**
+ * Load the related objects of some Relationships together with the records, in batched fetches,
+ * instead of firing one fault per record when each Relationship is accessed.
+ * @param listOfKeyPaths An Array of Relationship names or key paths, like <tt>@"customer"</tt> or <tt>@"items.product"</tt>.
+ * @return Return itself.
+ * @throw An  \ref JPDBManagerActionException  exception if some Relationship doesn't exist on the Entity.
+ */
+-(instancetype)applyPrefetchRelationships:(NSArray*)listOfKeyPaths;
+
 /**
  * Run this action on the associated
  * \
@@ -438,6 +543,136 @@
  */
 - (id)queryWithPredicate:(NSPredicate *)anPredicate sortDescriptors:(NSArray *)sortDescriptors;
 
+/**
+ * Query only the values of one property of the records matched by this action, without creating any Managed Object.
+ * @param anKey An Attribute name, to-one Relationship name or key path.
+ * @param distinct Pass <b>YES</b> to remove duplicated values.
+ * @return An Array with the values. Records without value doesn't contribute to it.
+ * @throw An  \ref JPDBManagerActionException  exception if the property doesn't exist on the Entity.
+ */
+- (NSArray *)queryValuesOfKey:(NSString *)anKey distinct:(BOOL)distinct;
+
+/**
+ * Query the record of specified Entity which one unique Key Attribute has the specified value.<br>
+ * Records registered on the context are kept on an in-memory index and returned without going to the store.
+ * The index is built once from the registered records, then kept up to date as records are fetched, inserted,
+ * changed or deleted, so one lookup never scans the context. The index holds the records weakly and is verified on
+ * every hit. Each context has his own index, use it only on the context queue like the context itself.
+ * @param anKey One Key attribute whose values are unique on this Entity.
+ * @param value The value to match.
+ * @return The record found or <tt>nil</tt>.
+ * @throw An  \ref JPDBManagerActionException  exception if the Key doesn't exist on the Entity. See \ref errors for more informations.
+ */
+- (id)queryRecordWithKey:(NSString *)anKey value:(id)value;
+
+//@}
+//// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// ////
+#pragma mark -
+#pragma mark Count and Aggregate Methods.
+//// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// ////
+/** @name Count and Aggregate Methods
+ * This methods are performed by the persistent store, no managed object is created. The predicate and the
+ * Fetch Template of this action are respected. Note that aggregates only consider data already committed,
+ * while counts also consider pending changes.
+ */
+///@{
+
+/**
+ * Count how many records this action match.
+ */
+- (NSUInteger)countRecords;
+
+/**
+ * Count how many distinct values of one attribute this action match.
+ * Core Data can't ask the store for a distinct count, so the distinct values are fetched (as dictionaries, no
+ * managed object is created) and counted in memory. The memory used grows with the number of distinct values,
+ * prefer #countRecords when the attribute is unique.
+ * @param anKey An Attribute name of the Entity.
+ * @throw An \ref JPDBManagerActionException exception if the attribute doesn't exist on the Entity.
+ */
+- (NSUInteger)countDistinctKey:(NSString *)anKey;
+
+/**
+ * Sum the values of one attribute of the records matched by this action.
+ * @param anKey An Attribute name of the Entity.
+ * @return The sum or <tt>nil</tt> if nothing was matched.
+ * @throw An \ref JPDBManagerActionException exception if the attribute doesn't exist on the Entity.
+ */
+- (NSNumber *)sumOfKey:(NSString *)anKey;
+
+/**
+ * Minimum value of one attribute of the records matched by this action.
+ * @param anKey An Attribute name of the Entity.
+ * @return The minimum value or <tt>nil</tt> if nothing was matched.
+ * @throw An \ref JPDBManagerActionException exception if the attribute doesn't exist on the Entity.
+ */
+- (id)minOfKey:(NSString *)anKey;
+
+/**
+ * Maximum value of one attribute of the records matched by this action.
+ * @param anKey An Attribute name of the Entity.
+ * @return The maximum value or <tt>nil</tt> if nothing was matched.
+ * @throw An \ref JPDBManagerActionException exception if the attribute doesn't exist on the Entity.
+ */
+- (id)maxOfKey:(NSString *)anKey;
+
+/**
+ * Average of the values of one attribute of the records matched by this action.
+ * @param anKey An Attribute name of the Entity.
+ * @return The average or <tt>nil</tt> if nothing was matched.
+ * @throw An \ref JPDBManagerActionException exception if the attribute doesn't exist on the Entity.
+ */
+- (NSNumber *)averageOfKey:(NSString *)anKey;
+
+//@}
+//// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// ////
+#pragma mark -
+#pragma mark Asynchronous Query Methods.
+//// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// ////
+/** @name Asynchronous Query Methods
+ */
+///@{
+
+/**
+ * Perform this action on background and deliver his records to one block.<br>
+ * The fetch runs on one context of the pool (see JPDBManager::performBlock:) and only the Object IDs are
+ * passed back, the records are then rebuilt on the context of this action, or on the main context if not defined.
+ * @param completion Block that receive the records.
+ * @param onMainQueue Pass <b>YES</b> to rebuild the records on the main context and call the block on the main queue,
+ * whatever the context of this action. Pass <b>NO</b> to do it on the queue of the action context.
+ * @return An handle to cancel the query.
+ */
+- (JPDBManagerAsyncQuery *)runWithCompletion:(JPDBManagerQueryBlock)completion onMainQueue:(BOOL)onMainQueue;
+
+/**
+ * Perform this action on background and deliver his records on the main queue.
+ * Same as #runWithCompletion:onMainQueue: passing <b>YES</b>.
+ * @param completion Block that receive the records.
+ * @return An handle to cancel the query.
+ */
+- (JPDBManagerAsyncQuery *)runAsync:(JPDBManagerQueryBlock)completion;
+
+//@}
+//// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// ////
+#pragma mark -
+#pragma mark Batch Enumeration Methods.
+//// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// ////
+/** @name Batch Enumeration Methods
+ */
+///@{
+
+/**
+ * Enumerate all records queried by this action in fixed size batches.
+ * The Object IDs are queried one page per batch, and each batch is fetched fully when his turn comes and turned
+ * back into faults after the block returns, inside his own autorelease pool. So only one batch is held at a time,
+ * no matter how big the Entity is. Records with unsaved changes aren't turned into faults.
+ * The predicate, Fetch Template, sort keys and fetch limits of this action are respected. Pages are queried by
+ * offset, so records inserted or deleted meanwhile can shift them, and without sort keys the store order is used.
+ * @param batchSize How many records each batch should have. Pass 0 to use \ref JPDBManagerDefaultBatchSize.
+ * @param block Block called for every batch. Set <tt>*stop</tt> to <b>YES</b> to stop the enumeration.
+ */
+- (void)enumerateInBatchesOfSize:(NSUInteger)batchSize usingBlock:(JPDBManagerBatchBlock)block;
+
 //@}
 
 //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// ////
@@ -464,18 +699,31 @@
 
 /**
  * Delete all records queried by the specified Fetch Template.
- * This method will use the #commitTransaction property to decide if commit automatically this change.
+ * Records are deleted and committed in batches of \ref JPDBManagerDefaultBatchSize, see #deleteRecordsInBatchesOfSize:.
 
  * @param anFetchName An Fetch Template to perform the query.
+ * @return How many records was deleted.
  */
-- (void)deleteRecordsWithFetchTemplate:(NSString *)anFetchName;
+- (NSUInteger)deleteRecordsWithFetchTemplate:(NSString *)anFetchName;
 
 /**
  * Delete all Records from specified Entity.
- * This could be a consuming operation on large databases.
+ * Records are deleted and committed in batches of \ref JPDBManagerDefaultBatchSize, see #deleteRecordsInBatchesOfSize:.
+ * @return How many records was deleted.
+ */
+- (NSUInteger)deleteAllRecords;
 
+/**
+ * Delete all records matched by this action in bounded batches.
+ * Only the Object IDs of the records are queried, the records aren't loaded. The fetch limits of this action are
+ * respected. The delete rules of the model (like cascades) are applied at the end of every batch. Every batch is
+ * committed on his own, regardless of #commitTransaction, so the memory stays bounded.<br>
+ * Without an specific #context the records are deleted on one context of the pool, synchronously, so other
+ * changes pending on the main context aren't committed with them.
+ * @param batchSize How many records each batch should delete. Pass 0 to use \ref JPDBManagerDefaultBatchSize.
+ * @return How many records was deleted. Records deleted by cascade rules aren't counted.
  */
-- (void)deleteAllRecords;
+- (NSUInteger)deleteRecordsInBatchesOfSize:(NSUInteger)batchSize;
 
 //@}
 //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// 
@@ -498,6 +746,35 @@
  */
 -(id)createNewRecord;
 
+/**
+ * Import records to the loaded Entity from dictionaries, like the ones created by JPJSONProcesser.
+ * Records are imported in batches of \ref JPDBManagerDefaultBatchSize. See #importRecords:inBatchesOfSize:progress:.
+ * @param records An NSArray or an NSEnumerator of NSDictionary objects.
+ * @return How many records was imported.
+ */
+-(NSUInteger)importRecords:(id)records;
+
+/**
+ * Import records to the loaded Entity from dictionaries, like the ones created by JPJSONProcesser.
+ * Every key of the dictionary is mapped to an Attribute using the #importKeyMap, keys that doesn't exist on the
+ * Entity are ignored. Values are converted to the Attribute type when needed: strings to numbers, numbers to
+ * strings and numbers to dates (as seconds since 1970). <b>NSNull</b> values are imported as <tt>nil</tt>.<br>
+ * <br>
+ * Every batch is inserted inside his own autorelease pool and is committed once, regardless of the
+ * #commitTransaction property. After the commit the imported records are turned into faults.<br>
+ * <br>
+ * Without an specific #context the records are imported on one context of the pool, synchronously, so other
+ * changes pending on the main context aren't committed with them. The imported records reach the main context
+ * when his changes are merged. In that case the <tt>progress</tt> block is called on the queue of that context.
+ * @param records An NSArray or an NSEnumerator of NSDictionary objects.
+ * @param batchSize How many records each batch should have. Pass 0 to use \ref JPDBManagerDefaultBatchSize.
+ * @param progress Optional block called after every committed batch.
+ * @return How many records was imported.
+ * @throw An  \ref JPDBManagerActionException  exception if one of the records isn't an NSDictionary. The batches
+ * already committed are kept.
+ */
+-(NSUInteger)importRecords:(id)records inBatchesOfSize:(NSUInteger)batchSize progress:(JPDBManagerImportProgressBlock)progress;
+
 //@}
 @end
 
@@ -15,8 +15,47 @@
  */
 #import "JPCore.h"
 #import "JPDBManagerAction.h"
+#import "JPDBManagerAsyncQuery.h"
+#import "JPDBManagerCursor.h"
 #import "JPDBManager.h"
 #import "NSMutableArray+ObjectiveSugar.h"
+#import <libkern/OSAtomic.h>
+#import <objc/runtime.h>
+
+////// ////// ////// ////// ////// ////// ////// ////// ////// ////// ////// ////// ////// ////// ////// //////
+#pragma mark - Fault Counting.
+
+// Faults fired by the records of one action. Every record returned holds a reference to it.
+@interface JPDBManagerFaultCounter : NSObject {
+@public
+    volatile int32_t count;
+}
+@end
+
+@implementation JPDBManagerFaultCounter
+@end
+
+static BOOL JPDBManagerFaultCountingEnabled = NO;
+static char JPDBManagerFaultCounterKey;
+static void (*JPDBManagerOriginalWillAccessValueForKey)(id, SEL, NSString *);
+
+// Replace NSManagedObject willAccessValueForKey:, called by Core Data before any property access.
+static void JPDBManagerWillAccessValueForKey(NSManagedObject *self, SEL _cmd, NSString *key) {
+    JPDBManagerFaultCounter *counter = objc_getAssociatedObject(self, &JPDBManagerFaultCounterKey);
+
+    if (counter && ([self isFault]
+            || (key && self.entity.relationshipsByName[key] && [self hasFaultForRelationshipNamed:key])))
+        OSAtomicIncrement32Barrier(&counter->count);
+
+    JPDBManagerOriginalWillAccessValueForKey(self, _cmd, key);
+}
+
+////// ////// ////// ////// ////// ////// ////// ////// ////// ////// ////// ////// ////// ////// ////// //////
+
+@interface JPDBManagerAction () {
+    JPDBManagerFaultCounter *_faultCounter;
+}
+@end
 
 @implementation JPDBManagerAction
 
@@ -45,6 +84,37 @@
 
 #pragma mark - Getters and Setters.
 
++ (void)setFaultCountingEnabled:(BOOL)enabled {
+    static dispatch_once_t onceToken;
+
+    // Hook once, the hook does nothing for records without counter.
+    if (enabled) {
+        dispatch_once(&onceToken, ^{
+            Method method = class_getInstanceMethod([NSManagedObject class], @selector(willAccessValueForKey:));
+            JPDBManagerOriginalWillAccessValueForKey = (void *) method_setImplementation(method,
+                    (IMP) JPDBManagerWillAccessValueForKey);
+        });
+    }
+
+    JPDBManagerFaultCountingEnabled = enabled;
+}
+
++ (BOOL)isFaultCountingEnabled {
+    return JPDBManagerFaultCountingEnabled;
+}
+
+- (NSUInteger)faultsFired {
+    return _faultCounter ? (NSUInteger) _faultCounter->count : 0;
+}
+
+- (BOOL)returnsDictionaries {
+    return self.resultType == NSDictionaryResultType;
+}
+
+- (void)setReturnsDictionaries:(BOOL)newValue {
+    self.resultType = newValue ? NSDictionaryResultType : NSManagedObjectResultType;
+}
+
 - (void)setAscendingOrder:(BOOL)newValue {
     // If no changes, do nothing..
     if (self.ascendingOrder == newValue)
@@ -96,6 +166,88 @@
     [NSException raise:JPDBManagerActionException format:@"%@", anCause];
 }
 
+- (void)checkAttribute:(NSString *)anKey {
+    if (![self existAttribute:anKey inEntity:self.entityName])
+        [self throwExceptionWithCause:NSFormatString( @"The attribute '%@' doesn't exist on '%@' Entity.", anKey, self.entityName)];
+}
+
+// Properties to fetch and group can also be Relationships or key paths, only the first component is checked.
+- (void)checkProperty:(NSString *)anKey {
+    NSString *property = [[anKey componentsSeparatedByString:@"."] firstObject];
+
+    if (self.entity.propertiesByName[property] == nil)
+        [self throwExceptionWithCause:NSFormatString( @"The property '%@' doesn't exist on '%@' Entity.", anKey, self.entityName)];
+}
+
+// Commit the changes on the context of this action. Commits on the main context can be coalesced by the group commit.
+- (void)commitChanges {
+    if (self.context)
+        [[self getManagerOrDie] performSelector:@selector(commitContext:) withObject:self.context];
+    else
+        [[self getManagerOrDie] performSelector:@selector(scheduleCommit)];
+}
+
+// Commit one batch right now, the batch memory is only released after it is saved. Batched jobs always
+// run on an specific context, see 'performOnPool:'.
+- (void)commitBatch {
+    [[self getManagerOrDie] performSelector:@selector(commitContext:) withObject:self.context];
+}
+
+// Run one batched job with a copy of this action bound to one context of the pool, so each batch commit
+// only contains the changes of the job.
+- (NSUInteger)performOnPool:(NSUInteger (^)(JPDBManagerAction *worker))job {
+    JPDBManagerAction *worker = [[self derivedAction] applyImportKeyMap:_importKeyMap];
+    [worker setFetchOffset:(int) self.fetchOffset setFetchLimit:(int) self.fetchLimit];
+
+    __block NSUInteger result = 0;
+    __block NSException *failure = nil;
+
+    [[self getManagerOrDie] performBlockAndWait:^(NSManagedObjectContext *context) {
+        worker.context = context;
+
+        @try {
+            result = job(worker);
+        }
+        @catch (NSException *exception) {
+            // Discard the current batch, the previous ones are already committed.
+            [context rollback];
+            failure = exception;
+        }
+    }];
+
+    // Raise on the calling thread, not on the queue of the context.
+    [failure raise];
+
+    return result;
+}
+
+// Create a new action for the same Entity and Manager, carrying the query settings of this one.
+- (JPDBManagerAction *)derivedAction {
+    JPDBManagerAction *derived = [[self class] initWithEntityName:self.entityName andManager:[self getManagerOrDie]];
+
+    [[derived applyFetchTemplate:_fetchTemplate] applyFetchVariables:_fetchVariables];
+    [[derived applySortDescriptors:self.sortDescriptors] applyPredicate:self.predicate];
+    derived.relationshipKeyPathsForPrefetching = self.relationshipKeyPathsForPrefetching;
+    derived.commitTransaction = _commitTransaction;
+    derived.context = self.context;
+
+    return derived;
+}
+
+// Query only the Object IDs of the records matched by this action, limited as this action is.
+- (NSArray *)queryObjectIDs {
+    return [self queryObjectIDsAtOffset:self.fetchOffset limit:self.fetchLimit];
+}
+
+// Query only the Object IDs of one page of the records matched by this action.
+- (NSArray *)queryObjectIDsAtOffset:(NSUInteger)offset limit:(NSUInteger)limit {
+    JPDBManagerAction *derived = [self derivedAction];
+    [derived setFetchOffset:(int) offset setFetchLimit:(int) limit];
+    derived.resultType = NSManagedObjectIDResultType;
+
+    return [derived runAction];
+}
+
 
 
 
@@ -125,6 +277,87 @@
 
 }
 
+- (NSArray *)queryValuesOfKey:(NSString *)anKey distinct:(BOOL)distinct {
+
+    // Fetch only this property as dictionaries.
+    JPDBManagerAction *derived = [[self derivedAction] applyPropertiesToFetch:@[anKey]];
+    [derived setFetchOffset:(int) self.fetchOffset setFetchLimit:(int) self.fetchLimit];
+    derived.returnsDistinctResults = distinct;
+
+    NSArray *result = [derived runAction];
+    NSMutableArray *values = [NSMutableArray arrayWithCapacity:[result count]];
+
+    // Key paths are returned keyed by the whole path, nil values are just missing.
+    for (NSDictionary *record in result) {
+        id value = record[anKey];
+        if (value)
+            [values addObject:value];
+    }
+
+    return values;
+}
+
+- (id)queryRecordWithKey:(NSString *)anKey value:(id)value {
+    [self checkAttribute:anKey];
+
+    // In-memory index of this key on the context of this action. This is a private call.
+    NSMapTable *identityMap = [[self getManagerOrDie] performSelector:@selector(identityMapForKey:ofAction:)
+                                                            withObject:anKey
+                                                            withObject:self];
+
+    NSManagedObject *record = value ? [self registeredRecordWithKey:anKey value:value identityMap:identityMap] : nil;
+    if (record)
+        return record;
+
+    // Query only one record on the store.
+    JPDBManagerAction *lookup = [[[self derivedAction] applyFetchTemplate:nil] applySortDescriptors:nil];
+    [lookup applyPredicate:[NSPredicate predicateWithFormat:@"%K == %@", anKey, value]];
+    [lookup setFetchOffset:0 setFetchLimit:1];
+    lookup.returnActionAsArray = YES;
+
+    NSArray *data = [lookup runAction];
+    record = [data count] > 0 ? data[0] : nil;
+
+    // Index.
+    if (value) {
+        @synchronized (identityMap) {
+            if (record)
+                [identityMap setObject:record forKey:value];
+            else
+                [identityMap removeObjectForKey:value];
+        }
+    }
+
+    return record;
+}
+
+// Look for the record on the identity map. The manager keeps the map up to date as records are fetched,
+// inserted or changed. Every identity map is used by one context, but guarded against other threads.
+- (NSManagedObject *)registeredRecordWithKey:(NSString *)anKey value:(id)value identityMap:(NSMapTable *)identityMap {
+    NSManagedObject *record = [self indexedRecordWithKey:anKey value:value identityMap:identityMap];
+    if (record)
+        return record;
+
+    // Records inserted or changed since the last event aren't indexed yet, processing them index them.
+    NSManagedObjectContext *context = self.context ?: [[self getManagerOrDie] managedObjectContext];
+    if (![context hasChanges])
+        return nil;
+
+    [context processPendingChanges];
+    return [self indexedRecordWithKey:anKey value:value identityMap:identityMap];
+}
+
+// Verify the indexed record, he may be deleted or changed since then.
+- (NSManagedObject *)indexedRecordWithKey:(NSString *)anKey value:(id)value identityMap:(NSMapTable *)identityMap {
+    @synchronized (identityMap) {
+        NSManagedObject *record = [identityMap objectForKey:value];
+        if (record && !record.isDeleted && record.managedObjectContext && [[record valueForKey:anKey] isEqual:value])
+            return record;
+
+        return nil;
+    }
+}
+
 
 
 
@@ -232,8 +465,27 @@
 // Perform this action on the manager.
 - (id)runAction {
     // This is a private call.
-    return [[self getManagerOrDie] performSelector:@selector(performDatabaseAction:)
-                                        withObject:self];
+    id result = [[self getManagerOrDie] performSelector:@selector(performDatabaseAction:)
+                                             withObject:self];
+
+    if (JPDBManagerFaultCountingEnabled)
+        [self countFaultsOfRecords:result];
+
+    return result;
+}
+
+// Attach the counter of this action on the records returned.
+- (void)countFaultsOfRecords:(id)records {
+    if (![records isKindOfClass:[NSArray class]])
+        return;
+
+    if (!_faultCounter)
+        _faultCounter = [JPDBManagerFaultCounter new];
+
+    for (id record in records) {
+        if ([record isKindOfClass:[NSManagedObject class]])
+            objc_setAssociatedObject(record, &JPDBManagerFaultCounterKey, _faultCounter, OBJC_ASSOCIATION_RETAIN_NONATOMIC);
+    }
 }
 
 - (id)run {
@@ -242,6 +494,172 @@
 
 
 
+
+#pragma mark - Asynchronous Query Methods.
+- (JPDBManagerAsyncQuery *)runWithCompletion:(JPDBManagerQueryBlock)completion onMainQueue:(BOOL)onMainQueue {
+    JPDBManager *manager = [self getManagerOrDie];
+    JPDBManagerAsyncQuery *query = [JPDBManagerAsyncQuery new];
+
+    // Context that receive the records.
+    NSManagedObjectContext *targetContext = onMainQueue || !self.context ? manager.managedObjectContext : self.context;
+
+    // Query only the Object IDs on background.
+    JPDBManagerAction *derived = [self derivedAction];
+    derived.resultType = NSManagedObjectIDResultType;
+    [derived setFetchOffset:(int) self.fetchOffset setFetchLimit:(int) self.fetchLimit];
+
+    // Fetch the records on the target context in one round trip, with the same settings.
+    JPDBManagerAction *rehydrate = [[self derivedAction] applyFetchTemplate:nil];
+    rehydrate.context = targetContext;
+
+    [manager performBlock:^(NSManagedObjectContext *context) {
+        if (query.isCancelled)
+            return;
+
+        derived.context = context;
+        NSArray *objectIDs = [derived runAction];
+
+        // Rebuild the records on the target context.
+        void (^deliver)(void) = ^{
+            if (query.isCancelled)
+                return;
+
+            NSMutableArray *records = nil;
+            if (objectIDs) {
+                [rehydrate applyPredicate:[NSPredicate predicateWithFormat:@"self IN %@", objectIDs]];
+
+                NSMutableDictionary *recordsByID = [NSMutableDictionary dictionaryWithCapacity:[objectIDs count]];
+                for (NSManagedObject *record in [rehydrate runAction])
+                    recordsByID[record.objectID] = record;
+
+                // Keep the order of the background query.
+                records = [NSMutableArray arrayWithCapacity:[objectIDs count]];
+                for (NSManagedObjectID *objectID in objectIDs) {
+                    if (recordsByID[objectID])
+                        [records addObject:recordsByID[objectID]];
+                }
+            }
+
+            completion(records);
+        };
+
+        // Main queue and confined contexts lives on the main thread.
+        if (targetContext.concurrencyType == NSPrivateQueueConcurrencyType)
+            [targetContext performBlock:deliver];
+        else
+            dispatch_async(dispatch_get_main_queue(), deliver);
+    }];
+
+    return query;
+}
+
+- (JPDBManagerAsyncQuery *)runAsync:(JPDBManagerQueryBlock)completion {
+    return [self runWithCompletion:completion onMainQueue:YES];
+}
+
+
+
+
+#pragma mark - Count and Aggregate Methods.
+- (NSUInteger)countRecords {
+    // This is a private call.
+    return [[[self getManagerOrDie] performSelector:@selector(countWithAction:) withObject:self] unsignedIntegerValue];
+}
+
+- (NSUInteger)countDistinctKey:(NSString *)anKey {
+    [self checkAttribute:anKey];
+
+    // Fetch only the distinct values as dictionaries. The store applies DISTINCT but Core Data has no expression
+    // to count them, so the values are counted here.
+    JPDBManagerAction *derived = [[self derivedAction] applySortDescriptors:nil];
+    derived.resultType = NSDictionaryResultType;
+    derived.propertiesToFetch = @[anKey];
+    derived.returnsDistinctResults = YES;
+
+    return [[derived runAction] count];
+}
+
+- (NSNumber *)sumOfKey:(NSString *)anKey {
+    return [self aggregateFunction:@"sum:" ofKey:anKey];
+}
+
+- (id)minOfKey:(NSString *)anKey {
+    return [self aggregateFunction:@"min:" ofKey:anKey];
+}
+
+- (id)maxOfKey:(NSString *)anKey {
+    return [self aggregateFunction:@"max:" ofKey:anKey];
+}
+
+- (NSNumber *)averageOfKey:(NSString *)anKey {
+    return [self aggregateFunction:@"average:" ofKey:anKey];
+}
+
+// Perform an aggregate function on the persistent store as an expression fetch.
+- (id)aggregateFunction:(NSString *)function ofKey:(NSString *)anKey {
+    [self checkAttribute:anKey];
+
+    NSAttributeDescription *attribute = self.entity.attributesByName[anKey];
+
+    NSExpressionDescription *expression = [NSExpressionDescription new];
+    expression.name = @"result";
+    expression.expression = [NSExpression expressionForFunction:function
+                                                      arguments:@[[NSExpression expressionForKeyPath:anKey]]];
+    expression.expressionResultType = [function isEqualToString:@"average:"]
+            ? NSDoubleAttributeType
+            : attribute.attributeType;
+
+    // Fetch only the expression result as a dictionary.
+    JPDBManagerAction *derived = [[self derivedAction] applySortDescriptors:nil];
+    derived.resultType = NSDictionaryResultType;
+    derived.propertiesToFetch = @[expression];
+
+    NSArray *result = [derived runAction];
+    return [result count] > 0 ? result[0][@"result"] : nil;
+}
+
+
+
+
+#pragma mark - Batch Enumeration Methods.
+- (void)enumerateInBatchesOfSize:(NSUInteger)batchSize usingBlock:(JPDBManagerBatchBlock)block {
+    if (batchSize == 0)
+        batchSize = JPDBManagerDefaultBatchSize;
+
+    NSUInteger location = 0;
+    BOOL stop = NO;
+
+    while (!stop) {
+        @autoreleasepool {
+            NSUInteger length = batchSize;
+            if (self.fetchLimit > 0)
+                length = MIN(length, self.fetchLimit - location);
+
+            // Only the Object IDs of one batch are held at a time, queried page by page.
+            NSArray *objectIDs = length > 0 ? [self queryObjectIDsAtOffset:self.fetchOffset + location limit:length] : nil;
+            if ([objectIDs count] == 0)
+                break;
+
+            // Fetch this batch fully, keeping the same order.
+            JPDBManagerAction *batchAction = [[self derivedAction] applyFetchTemplate:nil];
+            [batchAction applyPredicate:[NSPredicate predicateWithFormat:@"self IN %@", objectIDs]];
+            NSArray *batch = [batchAction runAction];
+
+            block(batch, &stop);
+
+            // Release the row data of this batch. This is a private call.
+            [[self getManagerOrDie] performSelector:@selector(refaultRecords:) withObject:batch];
+
+            // The last page.
+            location += [objectIDs count];
+            if ([objectIDs count] < length)
+                break;
+        }
+    }
+}
+
+
+
 #pragma mark - Set Action Data Methods.
 - (id)applyEntity:(NSString *)anEntity {
 
@@ -270,6 +688,41 @@
     return self;
 }
 
+- (instancetype)applyPropertiesToFetch:(NSArray *)listOfKeys {
+    for (NSString *key in listOfKeys)
+        [self checkProperty:key];
+
+    self.propertiesToFetch = listOfKeys;
+    self.returnsDictionaries = YES;
+    return self;
+}
+
+- (instancetype)applyGroupBy:(NSArray *)listOfKeys {
+    for (NSString *key in listOfKeys)
+        [self checkProperty:key];
+
+    self.propertiesToGroupBy = listOfKeys;
+    self.returnsDictionaries = YES;
+    return self;
+}
+
+- (instancetype)applyPrefetchRelationships:(NSArray *)listOfKeyPaths {
+    for (NSString *keyPath in listOfKeyPaths) {
+        NSString *relationship = [[keyPath componentsSeparatedByString:@"."] firstObject];
+
+        if (self.entity.relationshipsByName[relationship] == nil)
+            [self throwExceptionWithCause:NSFormatString( @"The relationship '%@' doesn't exist on '%@' Entity.", keyPath, self.entityName)];
+    }
+
+    self.relationshipKeyPathsForPrefetching = listOfKeyPaths;
+    return self;
+}
+
+- (id)applyImportKeyMap:(NSDictionary *)anDictionary {
+    _importKeyMap = [anDictionary copy];
+    return self;
+}
+
 
 
 
@@ -381,6 +834,51 @@
     self.returnsObjectsAsFaults = NO;
     self.ascendingOrder = YES;
     self.returnActionAsArray = YES;
+    ////
+    self.returnsDictionaries = NO;
+    self.returnsDistinctResults = NO;
+    self.propertiesToFetch = nil;
+    self.propertiesToGroupBy = nil;
+    self.relationshipKeyPathsForPrefetching = nil;
+}
+
+- (NSArray *)nextPageAfterCursor:(JPDBManagerCursor *)cursor {
+    if ([self.sortDescriptors count] == 0)
+        [self throwExceptionWithCause:@"Paginate with an cursor needs at least one sort descriptor."];
+
+    // Templates replace the predicate when loaded.
+    if (_fetchTemplate)
+        [self throwExceptionWithCause:@"Paginate with an cursor doesn't support Fetch Templates, use an predicate."];
+
+    for (NSSortDescriptor *sort in self.sortDescriptors) {
+        if (![JPDBManagerCursor supportsSortDescriptor:sort])
+            [self throwExceptionWithCause:NSFormatString(@"Paginate with an cursor doesn't support sorting by '%@', use compare: or caseInsensitiveCompare:.",
+                                                         NSStringFromSelector(sort.selector))];
+    }
+
+    if (!cursor.hasMorePages)
+        return @[];
+
+    // Records after the last one read, matching the query of this action.
+    JPDBManagerAction *page = [self derivedAction];
+    NSPredicate *after = [cursor predicateAfterLastRecordWithSortDescriptors:self.sortDescriptors];
+    if (after)
+        [page applyPredicate:self.predicate
+                ? [NSCompoundPredicate andPredicateWithSubpredicates:@[self.predicate, after]]
+                : after];
+
+    // One more record tell us if there's another page.
+    [page setFetchOffset:0 setFetchLimit:(int) cursor.pageSize + 1];
+    page.returnActionAsArray = YES;
+
+    NSArray *records = [page runAction];
+    BOOL hasMorePages = [records count] > cursor.pageSize;
+    if (hasMorePages)
+        records = [records subarrayWithRange:NSMakeRange(0, cursor.pageSize)];
+
+    [cursor moveAfterRecord:[records lastObject] sortDescriptors:self.sortDescriptors hasMorePages:hasMorePages];
+
+    return records ?: @[];
 }
 
 - (instancetype)all {
@@ -399,12 +897,128 @@
 
     // Commit after creation if needed.
     if (_commitTransaction)
-        [[self getManagerOrDie] commit];
+        [self commitChanges];
 
     // Return result.
     return result;
 }
 
+- (NSUInteger)importRecords:(id)records {
+    return [self importRecords:records inBatchesOfSize:JPDBManagerDefaultBatchSize progress:nil];
+}
+
+- (NSUInteger)importRecords:(id)records inBatchesOfSize:(NSUInteger)batchSize
+                   progress:(JPDBManagerImportProgressBlock)progress {
+
+    // Without an specific context, import on one context of the pool. Committing the main context would
+    // also commit every unrelated change pending on it.
+    if (!self.context) {
+        return [self performOnPool:^NSUInteger(JPDBManagerAction *worker) {
+            return [worker importRecords:records inBatchesOfSize:batchSize progress:progress];
+        }];
+    }
+
+    if (batchSize == 0)
+        batchSize = JPDBManagerDefaultBatchSize;
+
+    // Arrays are enumerated as any other enumerator, so every batch can have his own autorelease pool.
+    NSEnumerator *enumerator = [records isKindOfClass:[NSEnumerator class]] ? records : [records objectEnumerator];
+    NSDictionary *attributes = self.entity.attributesByName;
+
+    NSDate *start = [NSDate date];
+    NSUInteger imported = 0;
+    BOOL stop = NO;
+
+    while (!stop) {
+        @autoreleasepool {
+            NSMutableArray *batch = [NSMutableArray arrayWithCapacity:batchSize];
+
+            id record;
+            while ([batch count] < batchSize && (record = [enumerator nextObject])) {
+                [batch addObject:[self importRecord:record withAttributes:attributes]];
+            }
+
+            // Nothing else to import.
+            if ([batch count] == 0)
+                break;
+
+            // One commit per batch, and release the row data after it. This is a private call.
+            [self commitBatch];
+            [[self getManagerOrDie] performSelector:@selector(refaultRecords:) withObject:batch];
+
+            imported += [batch count];
+
+            if (progress) {
+                NSTimeInterval elapsed = MAX(-[start timeIntervalSinceNow], DBL_EPSILON);
+                progress(imported, imported / elapsed, &stop);
+            }
+        }
+    }
+
+    return imported;
+}
+
+// Create one new record and fill it with the values of an imported dictionary.
+- (id)importRecord:(id)record withAttributes:(NSDictionary *)attributes {
+    if (![record isKindOfClass:[NSDictionary class]])
+        [self throwExceptionWithCause:NSFormatString( @"Only dictionaries can be imported, found an '%@'.",
+                                                                NSStringFromClass([record class]) )];
+
+    // Perform creation. This is a private call.
+    id object = [[self getManagerOrDie] performSelector:@selector(createNewRecordFromAction:) withObject:self];
+
+    for (NSString *key in record) {
+        NSString *attributeName = _importKeyMap[key] ?: key;
+        NSAttributeDescription *attribute = attributes[attributeName];
+
+        // Ignore keys that doesn't exist on the Entity.
+        if (!attribute)
+            continue;
+
+        [object setValue:[self importValue:record[key] forAttribute:attribute] forKey:attributeName];
+    }
+
+    return object;
+}
+
+// Convert an imported value to the Attribute type, when needed.
+- (id)importValue:(id)value forAttribute:(NSAttributeDescription *)attribute {
+    if (value == [NSNull null])
+        return nil;
+
+    BOOL isString = [value isKindOfClass:[NSString class]];
+    BOOL isNumber = [value isKindOfClass:[NSNumber class]];
+
+    switch (attribute.attributeType) {
+        case NSInteger16AttributeType:
+        case NSInteger32AttributeType:
+        case NSInteger64AttributeType:
+            return isString ? @([value longLongValue]) : value;
+
+        case NSDoubleAttributeType:
+        case NSFloatAttributeType:
+            return isString ? @([value doubleValue]) : value;
+
+        case NSBooleanAttributeType:
+            return isString ? @([value boolValue]) : value;
+
+        case NSDecimalAttributeType:
+            if (isString)
+                return [NSDecimalNumber decimalNumberWithString:value];
+            if (isNumber && ![value isKindOfClass:[NSDecimalNumber class]])
+                return [NSDecimalNumber decimalNumberWithDecimal:[value decimalValue]];
+            return value;
+
+        case NSStringAttributeType:
+            return isNumber ? [value stringValue] : value;
+
+        case NSDateAttributeType:
+            return isNumber ? [NSDate dateWithTimeIntervalSince1970:[value doubleValue]] : value;
+
+        default:
+            return value;
+    }
+}
 
 
 
@@ -412,22 +1026,53 @@
 #pragma mark - Remove Data Methods.
 
 // Delete all Records from specified entityName.
-- (void)deleteAllRecords {
-    [self deleteRecordsWithFetchTemplate:nil];
+- (NSUInteger)deleteAllRecords {
+    return [self deleteRecordsWithFetchTemplate:nil];
 }
 
 // Delete all records, use an Fetch Template to query for an specified entityName.
-- (void)deleteRecordsWithFetchTemplate:(NSString *)anFetchName {
-    id entityData = [self queryWithFetchTemplate:anFetchName];
+- (NSUInteger)deleteRecordsWithFetchTemplate:(NSString *)anFetchName {
+    [[self applyFetchTemplate:anFetchName] applyFetchVariables:nil];
+    [[self applySortDescriptors:nil] applyPredicate:nil];
+    [self resetFetchLimits];
+
+    return [self deleteRecordsInBatchesOfSize:JPDBManagerDefaultBatchSize];
+}
+
+// Delete all records matched by this action, only his Object IDs are queried.
+- (NSUInteger)deleteRecordsInBatchesOfSize:(NSUInteger)batchSize {
+
+    // Without an specific context, delete on one context of the pool. Committing the main context would
+    // also commit every unrelated change pending on it.
+    if (!self.context) {
+        return [self performOnPool:^NSUInteger(JPDBManagerAction *worker) {
+            return [worker deleteRecordsInBatchesOfSize:batchSize];
+        }];
+    }
+
+    if (batchSize == 0)
+        batchSize = JPDBManagerDefaultBatchSize;
+
+    NSArray *objectIDs = [self queryObjectIDs];
+    NSUInteger total = [objectIDs count];
 
     /////// /////// /////// /////// /////// /////// ///////
-    // Loop deleting records.
-    for (id object in entityData)
-        [self deleteRecord:object andCommit:NO];
+    // Loop deleting batches.
+    for (NSUInteger location = 0; location < total; location += batchSize) {
+        @autoreleasepool {
+            NSArray *batch = [objectIDs subarrayWithRange:NSMakeRange(location, MIN(batchSize, total - location))];
+
+            // Delete Records From Managed Context. This is a private call.
+            [[self getManagerOrDie] performSelector:@selector(deleteRecordsWithIDs:fromAction:)
+                                         withObject:batch
+                                         withObject:self];
+
+            // Commit every batch, the memory of the deleted records is only released after it is saved.
+            [self commitBatch];
+        }
+    }
 
-    // Commit after delete if needed.
-    if (_commitTransaction)
-        [[self getManagerOrDie] commit];
+    return total;
 }
 
 // Delete an record of database. Use the Default Setting to Commit Automatically decision.
@@ -444,7 +1089,7 @@
 
     // Commit if asked...
     if (shouldCommit)
-        [[self getManagerOrDie] commit];
+        [self commitChanges];
 }
 
 
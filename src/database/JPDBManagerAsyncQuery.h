@@ -0,0 +1,36 @@
+/*
+ * Created by Paulo Oliveira at 2011. JUMP version 2, Copyright (c) 2014 - seqoy.org and Paulo Oliveira ( http://www.seqoy.org )
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#import <Foundation/Foundation.h>
+
+/**
+ * \class JPDBManagerAsyncQuery
+ * Handle of one query running on background, returned by JPDBManagerAction::runWithCompletion:onMainQueue:.
+ * Cancelling the query doesn't interrupt a fetch already executing on the store, but his result is
+ * discarded and the completion block is never called.
+ */
+@interface JPDBManagerAsyncQuery : NSObject
+
+/**
+ * <b>YES</b> after #cancel was called.
+ */
+@property(readonly, getter=isCancelled) BOOL cancelled;
+
+/**
+ * Cancel this query. Can be called from any thread.
+ */
+- (void)cancel;
+
+@end
@@ -0,0 +1,34 @@
+/*
+ * Created by Paulo Oliveira at 2011. JUMP version 2, Copyright (c) 2014 - seqoy.org and Paulo Oliveira ( http://www.seqoy.org )
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#import <libkern/OSAtomic.h>
+#import "JPDBManagerAsyncQuery.h"
+
+@interface JPDBManagerAsyncQuery () {
+    volatile int32_t _cancelled;
+}
+@end
+
+@implementation JPDBManagerAsyncQuery
+
+- (BOOL)isCancelled {
+    return _cancelled != 0;
+}
+
+- (void)cancel {
+    OSAtomicOr32Barrier(1, (volatile uint32_t *) &_cancelled);
+}
+
+@end
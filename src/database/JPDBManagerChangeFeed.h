@@ -0,0 +1,111 @@
+/*
+ * Created by Paulo Oliveira at 2011. JUMP version 2, Copyright (c) 2014 - seqoy.org and Paulo Oliveira ( http://www.seqoy.org )
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#import <Foundation/Foundation.h>
+#import <CoreData/CoreData.h>
+
+/**
+ * \class JPDBManagerChange
+ * Changes of one Entity written to the store by one save. Published by the JPDBManagerChangeFeed.
+ */
+@interface JPDBManagerChange : NSObject
+
+/**
+ * The changed Entity.
+ */
+@property(readonly) NSEntityDescription *entity;
+
+/**
+ * Name of the changed Entity.
+ */
+@property(readonly) NSString *entityName;
+
+/**
+ * Object IDs of the inserted records.
+ */
+@property(readonly) NSSet *insertedObjectIDs;
+
+/**
+ * Object IDs of the updated records.
+ */
+@property(readonly) NSSet *updatedObjectIDs;
+
+/**
+ * Object IDs of the deleted records.
+ */
+@property(readonly) NSSet *deletedObjectIDs;
+
+/**
+ * Keys changed on any of the updated records.
+ */
+@property(readonly) NSSet *changedKeys;
+
+/**
+ * Keys changed on one updated record. <tt>nil</tt> if the record wasn't updated.
+ */
+- (NSSet *)changedKeysOfObjectID:(NSManagedObjectID *)anObjectID;
+
+@end
+
+/**
+ * \class JPDBManagerChangeFeed
+ * Publish the changes written to one Persistent Store Coordinator. After each save to the store, the inserted,
+ * updated and deleted records are coalesced as one JPDBManagerChange per Entity and delivered to the subscribers,
+ * so listeners work on the changes instead of querying again or parsing the save notification themselves.<br>
+ * <br>
+ * Only saves that reach the store are published: contexts with one parent context are ignored, their changes are
+ * published when the parent is saved. The \link JPDBManager Database Manager\endlink uses one feed when
+ * JPDBManager::enableChangeFeed is set.
+ */
+@interface JPDBManagerChangeFeed : NSObject
+
+/**
+ * The Persistent Store Coordinator whose saves are published. Change it to keep the subscriptions when the
+ * Core Data is started again, nothing is published while it's <tt>nil</tt>.
+ */
+@property(weak) NSPersistentStoreCoordinator *coordinator;
+
+/**
+ * Init the feed, publishing the saves of one coordinator.
+ * @param anCoordinator The Persistent Store Coordinator whose saves are published. Can be <tt>nil</tt>.
+ */
++ (id)initWithCoordinator:(NSPersistentStoreCoordinator *)anCoordinator;
+
+/**
+ * Init the feed, publishing the saves of one coordinator.
+ * @param anCoordinator The Persistent Store Coordinator whose saves are published. Can be <tt>nil</tt>.
+ */
+- (id)initWithCoordinator:(NSPersistentStoreCoordinator *)anCoordinator;
+
+/**
+ * Receive the changes of some Entities.
+ * @param entityNames Entities to observe, changes of his sub entities are included. Pass <tt>nil</tt> to observe every Entity.
+ * @param keys Updated records are only delivered if one of this keys changed. Inserted and deleted records are
+ * always delivered. Pass <tt>nil</tt> to receive every update.
+ * @param queue Queue where the block is called. Pass <tt>nil</tt> to use the main queue.
+ * @param block Receive one JPDBManagerChange per changed Entity of one save. Never called with no changes.
+ * @return The subscription, pass it to #unsubscribe: to stop receiving changes.
+ */
+- (id)subscribeToEntities:(NSArray *)entityNames
+                     keys:(NSArray *)keys
+                    queue:(dispatch_queue_t)queue
+                    block:(void (^)(NSArray *changes))block;
+
+/**
+ * Stop receiving the changes of one subscription.
+ */
+- (void)unsubscribe:(id)subscription;
+
+@end
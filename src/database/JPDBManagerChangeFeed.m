@@ -0,0 +1,299 @@
+/*
+ * Created by Paulo Oliveira at 2011. JUMP version 2, Copyright (c) 2014 - seqoy.org and Paulo Oliveira ( http://www.seqoy.org )
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#import "JPDBManagerChangeFeed.h"
+
+@interface JPDBManagerChange () {
+    // Object ID -> Changed keys of each updated record.
+    NSDictionary *_changedKeysByObjectID;
+}
+- (id)initWithEntity:(NSEntityDescription *)anEntity inserted:(NSSet *)inserted updated:(NSDictionary *)updated deleted:(NSSet *)deleted;
+- (JPDBManagerChange *)changeFilteredByKeys:(NSSet *)keys;
+@end
+
+@implementation JPDBManagerChange
+
+- (id)initWithEntity:(NSEntityDescription *)anEntity inserted:(NSSet *)inserted updated:(NSDictionary *)updated deleted:(NSSet *)deleted {
+    self = [super init];
+    if (self != nil) {
+        _entity = anEntity;
+        _insertedObjectIDs = [inserted copy];
+        _updatedObjectIDs = [NSSet setWithArray:[updated allKeys]];
+        _deletedObjectIDs = [deleted copy];
+        _changedKeysByObjectID = [updated copy];
+
+        NSMutableSet *keys = [NSMutableSet set];
+        for (NSSet *objectKeys in [updated allValues])
+            [keys unionSet:objectKeys];
+        _changedKeys = [keys copy];
+    }
+    return self;
+}
+
+- (NSString *)entityName {
+    return _entity.name;
+}
+
+- (NSSet *)changedKeysOfObjectID:(NSManagedObjectID *)anObjectID {
+    return _changedKeysByObjectID[anObjectID];
+}
+
+// Changes seen by one subscriber interested on some keys. Nil if nothing is left.
+- (JPDBManagerChange *)changeFilteredByKeys:(NSSet *)keys {
+    NSDictionary *updated = _changedKeysByObjectID;
+
+    if (keys) {
+        NSMutableDictionary *filtered = [NSMutableDictionary dictionary];
+        [_changedKeysByObjectID enumerateKeysAndObjectsUsingBlock:^(NSManagedObjectID *objectID, NSSet *objectKeys, BOOL *stop) {
+            if ([objectKeys intersectsSet:keys])
+                filtered[objectID] = objectKeys;
+        }];
+        updated = filtered;
+    }
+
+    if ([_insertedObjectIDs count] == 0 && [updated count] == 0 && [_deletedObjectIDs count] == 0)
+        return nil;
+
+    return updated == _changedKeysByObjectID ? self
+            : [[JPDBManagerChange alloc] initWithEntity:_entity
+                                               inserted:_insertedObjectIDs
+                                                updated:updated
+                                                deleted:_deletedObjectIDs];
+}
+
+- (NSString *)description {
+    return [NSString stringWithFormat:@"<%@ %@: %lu inserted, %lu updated, %lu deleted, keys %@>",
+                                      NSStringFromClass([self class]), self.entityName,
+                                      (unsigned long) [_insertedObjectIDs count],
+                                      (unsigned long) [_updatedObjectIDs count],
+                                      (unsigned long) [_deletedObjectIDs count],
+                                      [[_changedKeys allObjects] componentsJoinedByString:@", "]];
+}
+
+@end
+
+////////// ///////// ///////// ///////// ///////// ///////// ///////// ///////// ///////// /////////
+
+// One subscriber of the feed.
+@interface JPDBManagerChangeSubscription : NSObject
+@property(copy) NSSet *entityNames;
+@property(copy) NSSet *keys;
+@property(strong) dispatch_queue_t queue;
+@property(copy) void (^block)(NSArray *changes);
+@end
+
+@implementation JPDBManagerChangeSubscription
+
+// Entity or any of his super entities was subscribed.
+- (BOOL)observesEntity:(NSEntityDescription *)entity {
+    if (!self.entityNames)
+        return YES;
+
+    for (NSEntityDescription *next = entity; next != nil; next = next.superentity) {
+        if ([self.entityNames containsObject:next.name])
+            return YES;
+    }
+    return NO;
+}
+
+@end
+
+////////// ///////// ///////// ///////// ///////// ///////// ///////// ///////// ///////// /////////
+
+@interface JPDBManagerChangeFeed () {
+    NSArray *_subscriptions;
+
+    // Context -> Object ID -> Changed keys, captured before each save.
+    NSMapTable *_pendingKeys;
+}
+@end
+
+@implementation JPDBManagerChangeFeed
+
+#pragma mark - Init Methods.
++ (id)initWithCoordinator:(NSPersistentStoreCoordinator *)anCoordinator {
+    return [[self alloc] initWithCoordinator:anCoordinator];
+}
+
+- (id)initWithCoordinator:(NSPersistentStoreCoordinator *)anCoordinator {
+    self = [super init];
+    if (self != nil) {
+        self.coordinator = anCoordinator;
+        _subscriptions = @[];
+        _pendingKeys = [NSMapTable weakToStrongObjectsMapTable];
+
+        // Contexts can be created anytime, observe all saves and filter by coordinator.
+        NSNotificationCenter *center = [NSNotificationCenter defaultCenter];
+        [center addObserver:self selector:@selector(contextWillSave:)
+                       name:NSManagedObjectContextWillSaveNotification object:nil];
+        [center addObserver:self selector:@selector(contextDidSave:)
+                       name:NSManagedObjectContextDidSaveNotification object:nil];
+    }
+    return self;
+}
+
+- (void)dealloc {
+    [[NSNotificationCenter defaultCenter] removeObserver:self];
+}
+
+
+
+
+#pragma mark - Subscription Methods.
+- (id)subscribeToEntities:(NSArray *)entityNames
+                     keys:(NSArray *)keys
+                    queue:(dispatch_queue_t)queue
+                    block:(void (^)(NSArray *changes))block {
+
+    JPDBManagerChangeSubscription *subscription = [JPDBManagerChangeSubscription new];
+    subscription.entityNames = entityNames ? [NSSet setWithArray:entityNames] : nil;
+    subscription.keys = keys ? [NSSet setWithArray:keys] : nil;
+    subscription.queue = queue ?: dispatch_get_main_queue();
+    subscription.block = block;
+
+    // Copy on write, publishing reads one immutable array without locking while delivering.
+    @synchronized (self) {
+        _subscriptions = [_subscriptions arrayByAddingObject:subscription];
+    }
+
+    return subscription;
+}
+
+- (void)unsubscribe:(id)subscription {
+    @synchronized (self) {
+        NSMutableArray *subscriptions = [_subscriptions mutableCopy];
+        [subscriptions removeObjectIdenticalTo:subscription];
+        _subscriptions = [subscriptions copy];
+    }
+}
+
+
+
+
+#pragma mark - Private Methods.
+
+// Only saves that write on the store of our coordinator.
+- (BOOL)publishesContext:(NSManagedObjectContext *)context {
+    NSPersistentStoreCoordinator *coordinator = self.coordinator;
+    return coordinator && context.parentContext == nil && context.persistentStoreCoordinator == coordinator;
+}
+
+// Coalesce the changes of one save per Entity.
+- (NSArray *)changesOfSave:(NSNotification *)notification keys:(NSDictionary *)keysByObjectID {
+    NSMutableDictionary *entities = [NSMutableDictionary dictionary];
+    NSMutableDictionary *inserted = [NSMutableDictionary dictionary];
+    NSMutableDictionary *updated = [NSMutableDictionary dictionary];
+    NSMutableDictionary *deleted = [NSMutableDictionary dictionary];
+
+    void (^collect)(NSString *, NSMutableDictionary *) = ^(NSString *changesKey, NSMutableDictionary *changes) {
+        for (NSManagedObject *object in notification.userInfo[changesKey]) {
+            NSString *name = object.entity.name;
+            entities[name] = object.entity;
+
+            if (changes == updated) {
+                if (!updated[name])
+                    updated[name] = [NSMutableDictionary dictionary];
+                updated[name][object.objectID] = keysByObjectID[object.objectID] ?: [NSSet set];
+            }
+            else {
+                if (!changes[name])
+                    changes[name] = [NSMutableSet set];
+                [changes[name] addObject:object.objectID];
+            }
+        }
+    };
+
+    collect(NSInsertedObjectsKey, inserted);
+    collect(NSUpdatedObjectsKey, updated);
+    collect(NSDeletedObjectsKey, deleted);
+
+    NSMutableArray *changes = [NSMutableArray arrayWithCapacity:[entities count]];
+    for (NSString *name in entities) {
+        [changes addObject:[[JPDBManagerChange alloc] initWithEntity:entities[name]
+                                                            inserted:inserted[name] ?: [NSSet set]
+                                                             updated:updated[name] ?: @{}
+                                                             deleted:deleted[name] ?: [NSSet set]]];
+    }
+
+    return changes;
+}
+
+
+
+
+#pragma mark - Notifications.
+
+// Changed keys are only known before the save. This is called on the context queue.
+- (void)contextWillSave:(NSNotification *)notification {
+    NSManagedObjectContext *context = notification.object;
+
+    if (![self publishesContext:context] || [_subscriptions count] == 0)
+        return;
+
+    // Inserted records only have temporary IDs now, all his keys are new anyway.
+    NSMutableDictionary *keys = [NSMutableDictionary dictionary];
+    for (NSManagedObject *object in [context updatedObjects])
+        keys[object.objectID] = [NSSet setWithArray:[[object changedValues] allKeys]];
+
+    @synchronized (self) {
+        [_pendingKeys setObject:keys forKey:context];
+    }
+}
+
+- (void)contextDidSave:(NSNotification *)notification {
+    NSManagedObjectContext *context = notification.object;
+
+    if (![self publishesContext:context])
+        return;
+
+    NSArray *subscriptions;
+    NSDictionary *keys;
+
+    @synchronized (self) {
+        subscriptions = _subscriptions;
+        keys = [_pendingKeys objectForKey:context];
+        [_pendingKeys removeObjectForKey:context];
+    }
+
+    if ([subscriptions count] == 0)
+        return;
+
+    NSArray *changes = [self changesOfSave:notification keys:keys];
+
+    ////// ////// //////
+    // Deliver what each subscriber asked for.
+    for (JPDBManagerChangeSubscription *subscription in subscriptions) {
+        NSMutableArray *delivered = [NSMutableArray array];
+
+        for (JPDBManagerChange *change in changes) {
+            if (![subscription observesEntity:change.entity])
+                continue;
+
+            JPDBManagerChange *filtered = [change changeFilteredByKeys:subscription.keys];
+            if (filtered)
+                [delivered addObject:filtered];
+        }
+
+        if ([delivered count] == 0)
+            continue;
+
+        void (^block)(NSArray *) = subscription.block;
+        dispatch_async(subscription.queue, ^{
+            block(delivered);
+        });
+    }
+}
+
+@end
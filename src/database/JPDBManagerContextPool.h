@@ -0,0 +1,77 @@
+/*
+ * Created by Paulo Oliveira at 2011. JUMP version 2, Copyright (c) 2014 - seqoy.org and Paulo Oliveira ( http://www.seqoy.org )
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#import <Foundation/Foundation.h>
+#import <CoreData/CoreData.h>
+
+/**
+ * \class JPDBManagerContextPool
+ * Pool of private queue Managed Object Contexts sharing the same Persistent Store Coordinator.
+ * Every context is confined to his own serial queue, so work performed on different contexts runs in parallel.
+ * The \link JPDBManager Database Manager\endlink owns one pool and use it to implement JPDBManager::performBlock:,
+ * you usually doesn't need to use this class directly.
+ */
+@interface JPDBManagerContextPool : NSObject
+
+/**
+ * All contexts of this pool.
+ */
+@property(readonly) NSArray *contexts;
+
+/**
+ * Init the pool creating his contexts.
+ * @param anCoordinator The Persistent Store Coordinator shared by all contexts.
+ * @param size How many contexts the pool should have. Pass 0 to use one context per active processor.
+ * @param mergePolicy Merge Policy of every context.
+ */
++ (id)initWithCoordinator:(NSPersistentStoreCoordinator *)anCoordinator size:(NSUInteger)size mergePolicy:(id)mergePolicy;
+
+/**
+ * Init the pool creating his contexts.
+ * @param anCoordinator The Persistent Store Coordinator shared by all contexts.
+ * @param size How many contexts the pool should have. Pass 0 to use one context per active processor.
+ * @param mergePolicy Merge Policy of every context.
+ */
+- (id)initWithCoordinator:(NSPersistentStoreCoordinator *)anCoordinator size:(NSUInteger)size mergePolicy:(id)mergePolicy;
+
+/**
+ * Test if one context belongs to this pool.
+ */
+- (BOOL)containsContext:(NSManagedObjectContext *)context;
+
+/**
+ * Asynchronously perform one block on the context of the pool with less pending work.
+ * @param block The block receive the context and is performed on the context queue.
+ */
+- (void)performBlock:(void (^)(NSManagedObjectContext *context))block;
+
+/**
+ * Synchronously perform one block on the context of the pool with less pending work.
+ * @param block The block receive the context and is performed on the context queue.
+ */
+- (void)performBlockAndWait:(void (^)(NSManagedObjectContext *context))block;
+
+/**
+ * Merge the changes of one <b>NSManagedObjectContextDidSaveNotification</b> on every context of the pool,
+ * except the context that was saved. Merges are performed asynchronously on each context queue.
+ */
+- (void)mergeChangesFromContextDidSaveNotification:(NSNotification *)notification;
+
+/**
+ * Wait until every block already scheduled on the pool finish.
+ */
+- (void)waitUntilAllBlocksAreFinished;
+
+@end
@@ -0,0 +1,143 @@
+/*
+ * Created by Paulo Oliveira at 2011. JUMP version 2, Copyright (c) 2014 - seqoy.org and Paulo Oliveira ( http://www.seqoy.org )
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#import <libkern/OSAtomic.h>
+#import "JPDBManagerContextPool.h"
+
+@interface JPDBManagerContextPool () {
+    // Pending blocks of each context, in the same order of the contexts array.
+    volatile int32_t *_pendingBlocks;
+}
+@end
+
+@implementation JPDBManagerContextPool
+
+#pragma mark - Init Methods.
++ (id)initWithCoordinator:(NSPersistentStoreCoordinator *)anCoordinator size:(NSUInteger)size mergePolicy:(id)mergePolicy {
+    return [[self alloc] initWithCoordinator:anCoordinator size:size mergePolicy:mergePolicy];
+}
+
+- (id)initWithCoordinator:(NSPersistentStoreCoordinator *)anCoordinator size:(NSUInteger)size mergePolicy:(id)mergePolicy {
+    self = [super init];
+    if (self != nil) {
+
+        // One context per processor by default.
+        if (size == 0)
+            size = MAX([[NSProcessInfo processInfo] activeProcessorCount], 1);
+
+        NSMutableArray *contexts = [NSMutableArray arrayWithCapacity:size];
+        for (NSUInteger i = 0; i < size; i++) {
+            NSManagedObjectContext *context = [[NSManagedObjectContext alloc]
+                    initWithConcurrencyType:NSPrivateQueueConcurrencyType];
+
+            [context setPersistentStoreCoordinator:anCoordinator];
+            [context setMergePolicy:mergePolicy];
+            [contexts addObject:context];
+        }
+
+        _contexts = [contexts copy];
+        _pendingBlocks = calloc(size, sizeof(int32_t));
+    }
+    return self;
+}
+
+- (void)dealloc {
+    free((void *) _pendingBlocks);
+}
+
+
+
+
+#pragma mark - Private Methods.
+
+// Index of the context with less pending blocks. Counters are read without locking,
+// an slightly outdated value only makes the choice less optimal.
+- (NSUInteger)leastBusyIndex {
+    NSUInteger found = 0;
+
+    for (NSUInteger i = 1; i < [_contexts count]; i++) {
+        if (_pendingBlocks[i] < _pendingBlocks[found])
+            found = i;
+    }
+
+    return found;
+}
+
+
+
+
+#pragma mark - Perform Methods.
+- (BOOL)containsContext:(NSManagedObjectContext *)context {
+    return [_contexts indexOfObjectIdenticalTo:context] != NSNotFound;
+}
+
+- (void)performBlock:(void (^)(NSManagedObjectContext *context))block {
+    NSUInteger index = [self leastBusyIndex];
+    NSManagedObjectContext *context = _contexts[index];
+
+    OSAtomicIncrement32Barrier(&_pendingBlocks[index]);
+
+    [context performBlock:^{
+        // Keep the counter right even if the block raises.
+        @try {
+            @autoreleasepool {
+                block(context);
+            }
+        }
+        @finally {
+            OSAtomicDecrement32Barrier(&_pendingBlocks[index]);
+        }
+    }];
+}
+
+- (void)performBlockAndWait:(void (^)(NSManagedObjectContext *context))block {
+    NSUInteger index = [self leastBusyIndex];
+    NSManagedObjectContext *context = _contexts[index];
+
+    OSAtomicIncrement32Barrier(&_pendingBlocks[index]);
+
+    @try {
+        [context performBlockAndWait:^{
+            @autoreleasepool {
+                block(context);
+            }
+        }];
+    }
+    @finally {
+        OSAtomicDecrement32Barrier(&_pendingBlocks[index]);
+    }
+}
+
+- (void)mergeChangesFromContextDidSaveNotification:(NSNotification *)notification {
+    for (NSManagedObjectContext *context in _contexts) {
+
+        // The saved context already have this changes.
+        if (context == notification.object)
+            continue;
+
+        [context performBlock:^{
+            [context mergeChangesFromContextDidSaveNotification:notification];
+        }];
+    }
+}
+
+- (void)waitUntilAllBlocksAreFinished {
+    // Each context queue is serial, an empty block waits everything scheduled before him.
+    for (NSManagedObjectContext *context in _contexts) {
+        [context performBlockAndWait:^{}];
+    }
+}
+
+@end
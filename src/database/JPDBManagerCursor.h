@@ -0,0 +1,84 @@
+/*
+ * Created by Paulo Oliveira at 2011. JUMP version 2, Copyright (c) 2014 - seqoy.org and Paulo Oliveira ( http://www.seqoy.org )
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#import <Foundation/Foundation.h>
+
+/**
+ * \class JPDBManagerCursor
+ * Position of one keyset pagination, used by JPDBManagerAction::nextPageAfterCursor:.<br>
+ * Instead of skipping rows with an offset, the cursor records the sort key values of the last record read and the
+ * next page queries only the records after them. Every page costs the same, no matter how deep it is.<br>
+ * <br>
+ * The sort keys must identify one record, make the last one unique (like an identifier) so records with the same
+ * values aren't skipped between pages. Sort keys shouldn't be optional, records without value aren't paginated.
+ */
+@interface JPDBManagerCursor : NSObject
+
+/**
+ * How many records each page should have.
+ */
+@property(readonly) NSUInteger pageSize;
+
+/**
+ * Sort key values of the last record read, in the same order of the sort descriptors.
+ * <tt>nil</tt> before the first page.
+ */
+@property(readonly) NSArray *lastValues;
+
+/**
+ * <b>NO</b> when the last page was read.
+ */
+@property(readonly) BOOL hasMorePages;
+
+/**
+ * Init one cursor positioned before the first page.
+ * @param pageSize How many records each page should have. Pass 0 to use \ref JPDBManagerDefaultPageSize.
+ */
++ (id)initWithPageSize:(NSUInteger)pageSize;
+
+/**
+ * Init one cursor positioned before the first page.
+ * @param pageSize How many records each page should have. Pass 0 to use \ref JPDBManagerDefaultPageSize.
+ */
+- (id)initWithPageSize:(NSUInteger)pageSize;
+
+/**
+ * Check if the records after the last one read can be matched for one sort descriptor. Only the <b>compare:</b>
+ * and <b>caseInsensitiveCompare:</b> selectors have one predicate comparison sorting the same way.
+ */
++ (BOOL)supportsSortDescriptor:(NSSortDescriptor *)sortDescriptor;
+
+/**
+ * Build the predicate that match only the records after the last one read.
+ * Raise one <b>JPDBManagerActionException</b> if some sort descriptor isn't supported.
+ * @param sortDescriptors The sort descriptors of the paginated query.
+ * @return The predicate or <tt>nil</tt> before the first page.
+ */
+- (NSPredicate *)predicateAfterLastRecordWithSortDescriptors:(NSArray *)sortDescriptors;
+
+/**
+ * Move the cursor after one record.
+ * @param anRecord The last record of the page read, an Managed Object or an dictionary.
+ * @param sortDescriptors The sort descriptors of the paginated query.
+ * @param hasMorePages <b>NO</b> if this was the last page.
+ */
+- (void)moveAfterRecord:(id)anRecord sortDescriptors:(NSArray *)sortDescriptors hasMorePages:(BOOL)hasMorePages;
+
+/**
+ * Move the cursor back to before the first page.
+ */
+- (void)reset;
+
+@end
@@ -0,0 +1,118 @@
+/*
+ * Created by Paulo Oliveira at 2011. JUMP version 2, Copyright (c) 2014 - seqoy.org and Paulo Oliveira ( http://www.seqoy.org )
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#import "JPDBManagerCursor.h"
+#import "JPDBManagerDefinitions.h"
+
+@implementation JPDBManagerCursor
+
+#pragma mark - Init Methods.
++ (id)initWithPageSize:(NSUInteger)pageSize {
+    return [[self alloc] initWithPageSize:pageSize];
+}
+
+- (id)initWithPageSize:(NSUInteger)pageSize {
+    self = [super init];
+    if (self != nil) {
+        // One empty page would never move the cursor.
+        _pageSize = pageSize > 0 ? pageSize : JPDBManagerDefaultPageSize;
+        [self reset];
+    }
+    return self;
+}
+
+- (void)reset {
+    _lastValues = nil;
+    _hasMorePages = YES;
+}
+
+
+
+
+#pragma mark - Cursor Methods.
+
+// Comparison options matching the order of one sort descriptor, or NSNotFound if no option does.
+static NSUInteger JPDBManagerCursorOptionsOfSort(NSSortDescriptor *sort) {
+    if (!sort.selector || sort.selector == @selector(compare:))
+        return 0;
+
+    if (sort.selector == @selector(caseInsensitiveCompare:))
+        return NSCaseInsensitivePredicateOption;
+
+    return NSNotFound;
+}
+
++ (BOOL)supportsSortDescriptor:(NSSortDescriptor *)sortDescriptor {
+    return JPDBManagerCursorOptionsOfSort(sortDescriptor) != NSNotFound;
+}
+
+- (NSPredicate *)predicateAfterLastRecordWithSortDescriptors:(NSArray *)sortDescriptors {
+    if (!_lastValues)
+        return nil;
+
+    //
+    // For the keys (a, b, c) the records after the last one (x, y, z) are:
+    //     a > x  OR  (a == x AND b > y)  OR  (a == x AND b == y AND c > z)
+    // Descending keys use '<' instead.
+    //
+    NSMutableArray *alternatives = [NSMutableArray arrayWithCapacity:[sortDescriptors count]];
+    NSMutableArray *equalities = [NSMutableArray arrayWithCapacity:[sortDescriptors count]];
+
+    [sortDescriptors enumerateObjectsUsingBlock:^(NSSortDescriptor *sort, NSUInteger index, BOOL *stop) {
+        id value = _lastValues[index];
+        NSExpression *key = [NSExpression expressionForKeyPath:sort.key];
+        NSExpression *last = [NSExpression expressionForConstantValue:value == [NSNull null] ? nil : value];
+
+        // Compare the same way the records were sorted.
+        NSUInteger options = JPDBManagerCursorOptionsOfSort(sort);
+        if (options == NSNotFound)
+            [NSException raise:JPDBManagerActionException
+                        format:@"Paginate with an cursor doesn't support sorting by '%@'.", NSStringFromSelector(sort.selector)];
+
+        NSPredicate *after = [NSComparisonPredicate predicateWithLeftExpression:key
+                                                                rightExpression:last
+                                                                       modifier:NSDirectPredicateModifier
+                                                                           type:sort.ascending ? NSGreaterThanPredicateOperatorType : NSLessThanPredicateOperatorType
+                                                                        options:options];
+
+        [alternatives addObject:[equalities count] > 0
+                ? [NSCompoundPredicate andPredicateWithSubpredicates:[equalities arrayByAddingObject:after]]
+                : after];
+
+        [equalities addObject:[NSComparisonPredicate predicateWithLeftExpression:key
+                                                                 rightExpression:last
+                                                                        modifier:NSDirectPredicateModifier
+                                                                            type:NSEqualToPredicateOperatorType
+                                                                         options:options]];
+    }];
+
+    return [NSCompoundPredicate orPredicateWithSubpredicates:alternatives];
+}
+
+- (void)moveAfterRecord:(id)anRecord sortDescriptors:(NSArray *)sortDescriptors hasMorePages:(BOOL)hasMorePages {
+    _hasMorePages = hasMorePages;
+
+    // An empty page keeps the position.
+    if (!anRecord)
+        return;
+
+    NSMutableArray *values = [NSMutableArray arrayWithCapacity:[sortDescriptors count]];
+    for (NSSortDescriptor *sort in sortDescriptors)
+        [values addObject:[anRecord valueForKeyPath:sort.key] ?: [NSNull null]];
+
+    _lastValues = [values copy];
+}
+
+@end
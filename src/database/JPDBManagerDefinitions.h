@@ -42,6 +42,99 @@
 // The Database Manager post an NSNotification of this type when some error ocurr performing some operation.
 #define JPDBManagerErrorNotification @"JPDBManagerErrorNotification"
 
+////// ////// ////// ////// ////// ////// ////// ////// ////// ////// ////// ////// ////// ////// ////// ////// ////// ////// ////// ////// 
+#pragma mark -
+#pragma mark Startup Phases Keys
+
+// Keys of the JPDBManager startupTimings dictionary. Each value is the duration of the phase in seconds.
+#define JPDBManagerStartupPhaseProtectedData  @"protectedData"   // Waiting the protected data became available.
+#define JPDBManagerStartupPhaseModelLoad      @"modelLoad"       // Loading the Managed Object Model.
+#define JPDBManagerStartupPhaseMigrationCheck @"migrationCheck"  // Checking if the store needs migration.
+#define JPDBManagerStartupPhaseStoreOpen      @"storeOpen"       // Opening the store, including any migration.
+#define JPDBManagerStartupPhaseWarmUp         @"warmUp"          // Warming up the store.
+#define JPDBManagerStartupPhaseTotal          @"total"           // Whole startup, until the main context is ready.
+
+////// ////// ////// ////// ////// ////// ////// ////// ////// ////// ////// ////// ////// ////// ////// ////// ////// ////// ////// ////// 
+#pragma mark -
+#pragma mark Metrics Keys
+
+// Keys of the events recorded by the JPDBManagerMetrics and passed to the JPDBManagerMetricsDelegate.
+#define JPDBManagerMetricEntity       @"entity"        // Entity name of the query.
+#define JPDBManagerMetricFetchType    @"fetchType"     // One of the fetch types below.
+#define JPDBManagerMetricTemplate     @"template"      // Fetch Template name, if any.
+#define JPDBManagerMetricDuration     @"duration"      // Wall time in seconds.
+#define JPDBManagerMetricRows         @"rows"          // Rows returned, or counted.
+#define JPDBManagerMetricInserted     @"inserted"      // Records inserted by one commit.
+#define JPDBManagerMetricUpdated      @"updated"       // Records updated by one commit.
+#define JPDBManagerMetricDeleted      @"deleted"       // Records deleted by one commit.
+#define JPDBManagerMetricDate         @"date"          // When the event was recorded.
+
+// Fetch types.
+#define JPDBManagerMetricFetchObjects      @"objects"
+#define JPDBManagerMetricFetchObjectIDs    @"objectIDs"
+#define JPDBManagerMetricFetchDictionaries @"dictionaries"
+#define JPDBManagerMetricFetchCount        @"count"
+#define JPDBManagerMetricFetchController   @"fetchedResultsController"
+
+////// ////// ////// ////// ////// ////// ////// ////// ////// ////// ////// ////// ////// ////// ////// ////// ////// ////// ////// ////// 
+#pragma mark -
+#pragma mark Store Profiles
+
+// Names of the profiles always registered on the JPDBManagerStoreConfiguration.
+#define JPDBManagerStoreProfileDefault     @"default"
+#define JPDBManagerStoreProfileWriteHeavy  @"writeHeavy"
+#define JPDBManagerStoreProfileReadHeavy   @"readHeavy"
+#define JPDBManagerStoreProfileInMemory    @"inMemory"
+
+// Model configuration of the Entities that wasn't assigned to any partition, see JPDBManager::addPartition:entities:configuration:.
+#define JPDBManagerDefaultPartition  @"JPDBManagerDefault"
+
+////// ////// ////// ////// ////// ////// ////// ////// ////// ////// ////// ////// ////// ////// ////// ////// ////// ////// ////// ////// 
+#pragma mark -
+#pragma mark Memory Governor Keys
+
+// Keys of the statistics returned by the JPDBManagerMemoryGovernor.
+#define JPDBManagerMemoryObjects   @"objects"     // Registered objects, including faults.
+#define JPDBManagerMemoryFaults    @"faults"      // Registered objects that are faults.
+#define JPDBManagerMemoryBytes     @"bytes"       // Estimated bytes of the registered objects.
+#define JPDBManagerMemoryEntities  @"entities"    // Same statistics for each Entity name.
+#define JPDBManagerMemoryBefore    @"before"      // Statistics before one collection.
+#define JPDBManagerMemoryAfter     @"after"       // Statistics after one collection.
+#define JPDBManagerMemoryReset     @"reset"       // If the collection reset the context.
+#define JPDBManagerMemoryDuration  @"duration"    // Duration of one collection in seconds.
+
+////// ////// ////// ////// ////// ////// ////// ////// ////// ////// ////// ////// ////// ////// ////// ////// ////// ////// ////// ////// 
+#pragma mark -
+#pragma mark Default Values
+
+// Default number of records processed on each batch by the batched operations.
+#define JPDBManagerDefaultBatchSize 500
+
+// Default number of records on each page read by one JPDBManagerCursor.
+#define JPDBManagerDefaultPageSize 50
+
+// Default number of parsed predicates kept by the JPDBManagerPredicateCache.
+#define JPDBManagerDefaultPredicateCacheSize 256
+
+// Number of bound predicates kept for each Fetch Template, one per set of variables.
+#define JPDBManagerDefaultFetchTemplateBindings 32
+
+// Default limits of the JPDBManagerQueryCache: cached queries and Object IDs stored by all of them.
+#define JPDBManagerDefaultQueryCacheSize 128
+#define JPDBManagerDefaultQueryCacheObjectIDs 20000
+
+// Default duration in seconds from which one query is written to the slow query log, and how many queries the log keeps.
+#define JPDBManagerDefaultSlowQueryThreshold 0.05
+#define JPDBManagerDefaultSlowQueryLogSize 100
+
+// Default window in seconds and number of writes after which the group commit saves the coalesced changes.
+#define JPDBManagerDefaultGroupCommitInterval 0.25
+#define JPDBManagerDefaultGroupCommitThreshold 200
+
+// Default limits of the JPDBManagerMemoryGovernor: registered objects and their estimated bytes.
+#define JPDBManagerDefaultMemoryObjectsLimit 10000
+#define JPDBManagerDefaultMemoryBytesLimit (32 * 1024 * 1024)
+
 ////// ////// ////// ////// ////// ////// ////// ////// ////// ////// ////// ////// ////// ////// ////// ////// ////// ////// ////// ////// 
 #pragma mark -
 #pragma mark Shortcuts Macro-Functions.
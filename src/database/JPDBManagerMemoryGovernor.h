@@ -0,0 +1,111 @@
+/*
+ * Created by Paulo Oliveira at 2011. JUMP version 2, Copyright (c) 2014 - seqoy.org and Paulo Oliveira ( http://www.seqoy.org )
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#import <Foundation/Foundation.h>
+#import <CoreData/CoreData.h>
+
+/**
+ * \class JPDBManagerMemoryGovernor
+ * Keep bounded the memory used by the objects registered on one Managed Object Context.<br>
+ * Registered objects are counted, and his memory estimated, per Entity. When the count or the estimated bytes
+ * cross the limits, the clean objects are turned back into faults, releasing his attribute values. Objects with
+ * unsaved changes are never touched. Set #resetContext to reset the whole context instead, when it has no changes.<br>
+ * <br>
+ * The \link JPDBManager Database Manager\endlink uses one governor on his main context when
+ * JPDBManager::enableMemoryGovernor is set, and also collects on every memory warning.
+ * You usually doesn't need to use this class directly.
+ */
+@interface JPDBManagerMemoryGovernor : NSObject
+
+/**
+ * The governed context.
+ */
+@property(readonly, weak) NSManagedObjectContext *context;
+
+/**
+ * Maximum number of registered objects. Default is \ref JPDBManagerDefaultMemoryObjectsLimit.
+ */
+@property(assign) NSUInteger objectsLimit;
+
+/**
+ * Maximum estimated bytes of the registered objects. Default is \ref JPDBManagerDefaultMemoryBytesLimit.
+ */
+@property(assign) NSUInteger bytesLimit;
+
+/**
+ * Set as 'YES' to reset the context when the limits are crossed and it has no unsaved changes.
+ * Objects held by the application became invalid after one reset, use it only if nobody holds them.
+ * Default value is <b>NO</b>, clean objects are turned into faults.
+ */
+@property(assign) BOOL resetContext;
+
+/**
+ * How many collections were performed.
+ */
+@property(readonly) NSUInteger collections;
+
+/**
+ * Statistics of the last collection, see #collect. <tt>nil</tt> if nothing was collected yet.
+ */
+@property(readonly) NSDictionary *lastCollection;
+
+/**
+ * Init the governor of one context.
+ * @param anContext The governed context. Is held weakly.
+ */
++ (id)initWithContext:(NSManagedObjectContext *)anContext;
+
+/**
+ * Init the governor of one context.
+ * @param anContext The governed context. Is held weakly.
+ */
+- (id)initWithContext:(NSManagedObjectContext *)anContext;
+
+/**
+ * Count and estimate the registered objects now. Keys are the <b>JPDBManagerMemory...</b> keys
+ * of JPDBManagerDefinitions.h: total <b>objects</b>, <b>faults</b> and <b>bytes</b>, and the same
+ * statistics for each Entity name on <b>entities</b>. Walks every registered object, don't call it on tight loops.
+ */
+- (NSDictionary *)statistics;
+
+/**
+ * Tell the governor that some objects were registered, by one query or one insert. This call is cheap,
+ * nothing is counted or collected here.
+ * @return <b>YES</b> after one tenth of #objectsLimit objects were noted since the last time, then the caller
+ * should call #collectIfNeededSparing: once the objects are handed out.
+ */
+- (BOOL)noteRegisteredObjects:(NSUInteger)count;
+
+/**
+ * Collect if the registered objects crossed the limits.
+ * @return The collection statistics, or <tt>nil</tt> if nothing was collected.
+ */
+- (NSDictionary *)collectIfNeeded;
+
+/**
+ * Collect if the registered objects crossed the limits, keeping some objects untouched, like the records of the
+ * last query. The context isn't reset while there are objects to spare, the clean objects are turned into faults instead.
+ * @param objects Objects that stay as they are. Can be <tt>nil</tt>.
+ * @return The collection statistics, or <tt>nil</tt> if nothing was collected.
+ */
+- (NSDictionary *)collectIfNeededSparing:(NSArray *)objects;
+
+/**
+ * Collect now, regardless of the limits. Return the #statistics <b>before</b> and <b>after</b> the collection,
+ * if the context was <b>reset</b> and the <b>duration</b> in seconds.
+ */
+- (NSDictionary *)collect;
+
+@end
@@ -0,0 +1,224 @@
+/*
+ * Created by Paulo Oliveira at 2011. JUMP version 2, Copyright (c) 2014 - seqoy.org and Paulo Oliveira ( http://www.seqoy.org )
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#import "JPDBManagerMemoryGovernor.h"
+#import "JPDBManagerDefinitions.h"
+
+// Rough cost in bytes of one registered object, and of each value it holds.
+static const NSUInteger JPDBManagerMemoryObjectOverhead = 64;
+static const NSUInteger JPDBManagerMemoryValueOverhead = 16;
+
+// Estimate the bytes used by one object. Faults only cost the object itself.
+static NSUInteger JPDBManagerEstimatedBytes(NSManagedObject *object) {
+    NSUInteger bytes = JPDBManagerMemoryObjectOverhead;
+
+    if ([object isFault])
+        return bytes;
+
+    // Primitive values doesn't fire faults neither the custom accessors.
+    for (NSString *name in [[object entity] attributesByName]) {
+        id value = [object primitiveValueForKey:name];
+
+        if ([value isKindOfClass:[NSString class]])
+            bytes += [value length] * sizeof(unichar);
+        else if ([value isKindOfClass:[NSData class]])
+            bytes += [value length];
+
+        bytes += JPDBManagerMemoryValueOverhead;
+    }
+
+    return bytes + [[[object entity] relationshipsByName] count] * sizeof(id);
+}
+
+@interface JPDBManagerMemoryGovernor () {
+    // Objects noted since the last count.
+    NSUInteger _noted;
+}
+@end
+
+@implementation JPDBManagerMemoryGovernor
+
+#pragma mark - Init Methods.
++ (id)initWithContext:(NSManagedObjectContext *)anContext {
+    return [[self alloc] initWithContext:anContext];
+}
+
+- (id)initWithContext:(NSManagedObjectContext *)anContext {
+    self = [super init];
+    if (self != nil) {
+        _context = anContext;
+        _objectsLimit = JPDBManagerDefaultMemoryObjectsLimit;
+        _bytesLimit = JPDBManagerDefaultMemoryBytesLimit;
+    }
+    return self;
+}
+
+
+
+
+#pragma mark - Private Methods.
+
+// Perform one block on the context queue, and wait.
+- (void)performOnContext:(void (^)(NSManagedObjectContext *context))block {
+    NSManagedObjectContext *context = self.context;
+    if (!context)
+        return;
+
+    if (context.concurrencyType == NSConfinementConcurrencyType)
+        block(context);
+    else
+        [context performBlockAndWait:^{
+            block(context);
+        }];
+}
+
+// Statistics of the objects of one context. This is called on the context queue.
+- (NSDictionary *)statisticsOfContext:(NSManagedObjectContext *)context {
+    NSMutableDictionary *entities = [NSMutableDictionary dictionary];
+    NSUInteger objects = 0, faults = 0, bytes = 0;
+
+    @autoreleasepool {
+        for (NSManagedObject *object in [context registeredObjects]) {
+            NSUInteger objectBytes = JPDBManagerEstimatedBytes(object);
+            NSUInteger isFault = [object isFault] ? 1 : 0;
+
+            NSString *name = [[object entity] name];
+            NSDictionary *entity = entities[name];
+
+            entities[name] = @{
+                    JPDBManagerMemoryObjects : @([entity[JPDBManagerMemoryObjects] unsignedIntegerValue] + 1),
+                    JPDBManagerMemoryFaults  : @([entity[JPDBManagerMemoryFaults] unsignedIntegerValue] + isFault),
+                    JPDBManagerMemoryBytes   : @([entity[JPDBManagerMemoryBytes] unsignedIntegerValue] + objectBytes)
+            };
+
+            objects++;
+            faults += isFault;
+            bytes += objectBytes;
+        }
+    }
+
+    return @{
+            JPDBManagerMemoryObjects  : @(objects),
+            JPDBManagerMemoryFaults   : @(faults),
+            JPDBManagerMemoryBytes    : @(bytes),
+            JPDBManagerMemoryEntities : [entities copy]
+    };
+}
+
+- (BOOL)statisticsAreOverLimits:(NSDictionary *)statistics {
+    return [statistics[JPDBManagerMemoryObjects] unsignedIntegerValue] > self.objectsLimit
+            || [statistics[JPDBManagerMemoryBytes] unsignedIntegerValue] > self.bytesLimit;
+}
+
+// Turn the clean objects into faults, or reset the context. This is called on the context queue.
+- (NSDictionary *)collectContext:(NSManagedObjectContext *)context before:(NSDictionary *)before sparing:(NSArray *)spared {
+    CFAbsoluteTime start = CFAbsoluteTimeGetCurrent();
+    BOOL reset = self.resetContext && ![context hasChanges] && [spared count] == 0;
+
+    // Compared by identity, hashing managed objects would fire faults.
+    NSHashTable *sparedObjects = [NSHashTable hashTableWithOptions:NSPointerFunctionsObjectPointerPersonality];
+    for (id object in spared)
+        [sparedObjects addObject:object];
+
+    @autoreleasepool {
+        if (reset) {
+            [context reset];
+        }
+        else {
+            for (NSManagedObject *object in [context registeredObjects]) {
+
+                // Changes are only released by one commit.
+                if ([object isFault] || [object isInserted] || [object isUpdated] || [object isDeleted])
+                    continue;
+
+                if ([sparedObjects containsObject:object])
+                    continue;
+
+                [context refreshObject:object mergeChanges:NO];
+            }
+        }
+    }
+
+    NSDictionary *collection = @{
+            JPDBManagerMemoryBefore   : before,
+            JPDBManagerMemoryAfter    : [self statisticsOfContext:context],
+            JPDBManagerMemoryReset    : @(reset),
+            JPDBManagerMemoryDuration : @(CFAbsoluteTimeGetCurrent() - start)
+    };
+
+    @synchronized (self) {
+        _lastCollection = collection;
+        _collections++;
+    }
+
+    return collection;
+}
+
+
+
+
+#pragma mark - Collect Methods.
+- (NSDictionary *)statistics {
+    __block NSDictionary *statistics = nil;
+
+    [self performOnContext:^(NSManagedObjectContext *context) {
+        statistics = [self statisticsOfContext:context];
+    }];
+
+    return statistics;
+}
+
+- (BOOL)noteRegisteredObjects:(NSUInteger)count {
+    @synchronized (self) {
+        _noted += count;
+
+        // Counting walks every object, do it only after a meaningful number of them.
+        if (_noted < MAX(self.objectsLimit / 10, 1))
+            return NO;
+
+        _noted = 0;
+    }
+
+    return YES;
+}
+
+- (NSDictionary *)collectIfNeeded {
+    return [self collectIfNeededSparing:nil];
+}
+
+- (NSDictionary *)collectIfNeededSparing:(NSArray *)objects {
+    __block NSDictionary *collection = nil;
+
+    [self performOnContext:^(NSManagedObjectContext *context) {
+        NSDictionary *before = [self statisticsOfContext:context];
+
+        if ([self statisticsAreOverLimits:before])
+            collection = [self collectContext:context before:before sparing:objects];
+    }];
+
+    return collection;
+}
+
+- (NSDictionary *)collect {
+    __block NSDictionary *collection = nil;
+
+    [self performOnContext:^(NSManagedObjectContext *context) {
+        collection = [self collectContext:context before:[self statisticsOfContext:context] sparing:nil];
+    }];
+
+    return collection;
+}
+
+@end
@@ -0,0 +1,77 @@
+/*
+ * Created by Paulo Oliveira at 2011. JUMP version 2, Copyright (c) 2014 - seqoy.org and Paulo Oliveira ( http://www.seqoy.org )
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#import <Foundation/Foundation.h>
+#import <CoreData/CoreData.h>
+
+/**
+ * \class JPDBManagerMetadata
+ * Immutable index of one Managed Object Model. Built once when the model is loaded, so the
+ * validations performed on every \link JPDBManagerAction Database Action\endlink doesn't need to
+ * query the model again. All lookups are dictionary reads, safe to perform from any thread without locking.
+ */
+@interface JPDBManagerMetadata : NSObject
+
+/**
+ * All Entities of the model, keyed by name.
+ */
+@property(readonly) NSDictionary *entitiesByName;
+
+/**
+ * All non abstract Entities of the model, keyed by the name of his Managed Object class.
+ */
+@property(readonly) NSDictionary *entitiesByClassName;
+
+/**
+ * Build the index of one model.
+ * @param anModel The Managed Object Model to index.
+ */
++ (id)initWithModel:(NSManagedObjectModel *)anModel;
+
+/**
+ * Build the index of one model.
+ * @param anModel The Managed Object Model to index.
+ */
+- (id)initWithModel:(NSManagedObjectModel *)anModel;
+
+/**
+ * Return the Entity with specified name, or the Entity mapped to one Managed Object class with this name.
+ * @return The Entity or <tt>nil</tt> if not found.
+ */
+- (NSEntityDescription *)entity:(NSString *)anEntityName;
+
+/**
+ * Test if specified Entity exist on the model. Accepts the same names than #entity:.
+ */
+- (BOOL)existEntity:(NSString *)anEntityName;
+
+/**
+ * Test if specified Attribute exist on specified Entity. The Entity can also be named by his Managed Object class.
+ */
+- (BOOL)existAttribute:(NSString *)anAttributeName inEntity:(NSString *)anEntityName;
+
+/**
+ * Return the type of one Attribute.
+ * @return The Attribute Type or <b>NSUndefinedAttributeType</b> if the Attribute doesn't exist.
+ */
+- (NSAttributeType)typeOfAttribute:(NSString *)anAttributeName inEntity:(NSString *)anEntityName;
+
+/**
+ * Return the destination Entity name of one Relationship.
+ * @return The destination Entity name or <tt>nil</tt> if the Relationship doesn't exist.
+ */
+- (NSString *)destinationOfRelationship:(NSString *)anRelationshipName inEntity:(NSString *)anEntityName;
+
+@end
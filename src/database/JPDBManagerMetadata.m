@@ -0,0 +1,116 @@
+/*
+ * Created by Paulo Oliveira at 2011. JUMP version 2, Copyright (c) 2014 - seqoy.org and Paulo Oliveira ( http://www.seqoy.org )
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#import "JPDBManagerMetadata.h"
+
+@interface JPDBManagerMetadata () {
+    // Entity name -> Attribute name -> Attribute Type.
+    NSDictionary *_attributeTypes;
+
+    // Entity name -> Relationship name -> Destination Entity name.
+    NSDictionary *_relationshipDestinations;
+}
+@end
+
+@implementation JPDBManagerMetadata
+
+#pragma mark - Init Methods.
++ (id)initWithModel:(NSManagedObjectModel *)anModel {
+    return [[self alloc] initWithModel:anModel];
+}
+
+- (id)initWithModel:(NSManagedObjectModel *)anModel {
+    self = [super init];
+    if (self != nil) {
+        NSMutableDictionary *entitiesByName = [NSMutableDictionary dictionary];
+        NSMutableDictionary *entitiesByClassName = [NSMutableDictionary dictionary];
+        NSMutableDictionary *attributeTypes = [NSMutableDictionary dictionary];
+        NSMutableDictionary *relationshipDestinations = [NSMutableDictionary dictionary];
+
+        for (NSEntityDescription *entity in [anModel entities]) {
+            entitiesByName[entity.name] = entity;
+
+            // Abstract entities can't be instantiated, and NSManagedObject is shared by every entity without class.
+            if (!entity.isAbstract && entity.managedObjectClassName
+                    && ![entity.managedObjectClassName isEqualToString:NSStringFromClass([NSManagedObject class])])
+                entitiesByClassName[entity.managedObjectClassName] = entity;
+
+            ////// ////// //////
+            // Attributes.
+            NSMutableDictionary *types = [NSMutableDictionary dictionary];
+            [entity.attributesByName enumerateKeysAndObjectsUsingBlock:^(NSString *name, NSAttributeDescription *attribute, BOOL *stop) {
+                types[name] = @(attribute.attributeType);
+            }];
+            attributeTypes[entity.name] = [types copy];
+
+            ////// ////// //////
+            // Relationships.
+            NSMutableDictionary *destinations = [NSMutableDictionary dictionary];
+            [entity.relationshipsByName enumerateKeysAndObjectsUsingBlock:^(NSString *name, NSRelationshipDescription *relationship, BOOL *stop) {
+                if (relationship.destinationEntity.name)
+                    destinations[name] = relationship.destinationEntity.name;
+            }];
+            relationshipDestinations[entity.name] = [destinations copy];
+        }
+
+        _entitiesByName = [entitiesByName copy];
+        _entitiesByClassName = [entitiesByClassName copy];
+        _attributeTypes = [attributeTypes copy];
+        _relationshipDestinations = [relationshipDestinations copy];
+    }
+    return self;
+}
+
+
+
+
+#pragma mark - Lookup Methods.
+- (NSEntityDescription *)entity:(NSString *)anEntityName {
+    if (!anEntityName)
+        return nil;
+
+    return _entitiesByName[anEntityName] ?: _entitiesByClassName[anEntityName];
+}
+
+- (BOOL)existEntity:(NSString *)anEntityName {
+    return [self entity:anEntityName] != nil;
+}
+
+- (BOOL)existAttribute:(NSString *)anAttributeName inEntity:(NSString *)anEntityName {
+    return anAttributeName && [self attributeTypesOfEntity:anEntityName][anAttributeName] != nil;
+}
+
+- (NSAttributeType)typeOfAttribute:(NSString *)anAttributeName inEntity:(NSString *)anEntityName {
+    if (![self existAttribute:anAttributeName inEntity:anEntityName])
+        return NSUndefinedAttributeType;
+
+    return (NSAttributeType) [[self attributeTypesOfEntity:anEntityName][anAttributeName] unsignedIntegerValue];
+}
+
+- (NSString *)destinationOfRelationship:(NSString *)anRelationshipName inEntity:(NSString *)anEntityName {
+    if (!anRelationshipName)
+        return nil;
+
+    NSString *entityName = [self entity:anEntityName].name;
+    return entityName ? _relationshipDestinations[entityName][anRelationshipName] : nil;
+}
+
+// Every lookup accepts the same names than #entity:, the indexes are keyed by the Entity name.
+- (NSDictionary *)attributeTypesOfEntity:(NSString *)anEntityName {
+    NSString *entityName = [self entity:anEntityName].name;
+    return entityName ? _attributeTypes[entityName] : nil;
+}
+
+@end
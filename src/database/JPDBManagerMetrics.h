@@ -0,0 +1,95 @@
+/*
+ * Created by Paulo Oliveira at 2011. JUMP version 2, Copyright (c) 2014 - seqoy.org and Paulo Oliveira ( http://www.seqoy.org )
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#import <Foundation/Foundation.h>
+
+@class JPDBManager;
+
+/**
+ * Receive the events recorded by the \link JPDBManager Database Manager\endlink when JPDBManager::enableMetrics is set.
+ * Events are dictionaries keyed by the <b>JPDBManagerMetric...</b> keys of JPDBManagerDefinitions.h.
+ * Methods are called on the thread that performed the operation.
+ */
+@protocol JPDBManagerMetricsDelegate <NSObject>
+@optional
+
+/**
+ * One query or count was performed.
+ */
+- (void)databaseManager:(JPDBManager *)manager didPerformQuery:(NSDictionary *)event;
+
+/**
+ * One context was saved.
+ */
+- (void)databaseManager:(JPDBManager *)manager didCommit:(NSDictionary *)event;
+
+@end
+
+/**
+ * \class JPDBManagerMetrics
+ * Thread safe accumulator of the queries and commits performed by one \link JPDBManager Database Manager\endlink.
+ * Keeps latency histograms per Entity, commit totals and a log of the slowest queries. Read everything at once
+ * with #snapshot.
+ */
+@interface JPDBManagerMetrics : NSObject
+
+/**
+ * Queries that take at least this duration in seconds are written to the slow query log.
+ * Default is \ref JPDBManagerDefaultSlowQueryThreshold.
+ */
+@property(assign) NSTimeInterval slowQueryThreshold;
+
+/**
+ * How many queries the slow query log keeps, older queries are discarded.
+ * Default is \ref JPDBManagerDefaultSlowQueryLogSize.
+ */
+@property(assign) NSUInteger slowQueryLogLimit;
+
+/**
+ * Set as 'YES' to also write the slow queries to the console. Default value is <b>NO</b>.
+ */
+@property(assign) BOOL logSlowQueries;
+
+/**
+ * Upper bounds in seconds of each histogram bucket. The last bucket has no bound.
+ */
++ (NSArray *)histogramBounds;
+
+/**
+ * Record one query event.
+ */
+- (void)recordQuery:(NSDictionary *)event;
+
+/**
+ * Record one commit event.
+ */
+- (void)recordCommit:(NSDictionary *)event;
+
+/**
+ * Immutable copy of everything recorded until now:<br>
+ * - <b>entities</b>: for each Entity name, the <b>count</b>, <b>rows</b>, <b>totalTime</b>, <b>maxTime</b> and
+ *   <b>histogram</b> of his queries. Histogram counts are in the same order of #histogramBounds.
+ * - <b>commits</b>: same statistics for the commits, plus the <b>inserted</b>, <b>updated</b> and <b>deleted</b> totals.
+ * - <b>slowQueries</b>: the slow query log, oldest first.
+ * .
+ */
+- (NSDictionary *)snapshot;
+
+/**
+ * Discard everything recorded.
+ */
+- (void)reset;
+
+@end
@@ -0,0 +1,166 @@
+/*
+ * Created by Paulo Oliveira at 2011. JUMP version 2, Copyright (c) 2014 - seqoy.org and Paulo Oliveira ( http://www.seqoy.org )
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#import "JPDBManagerMetrics.h"
+#import "JPDBManagerDefinitions.h"
+
+// Upper bounds of the histogram buckets, in seconds. One more bucket holds everything above.
+static const double JPDBManagerMetricsBounds[] = {0.001, 0.002, 0.005, 0.01, 0.02, 0.05, 0.1, 0.2, 0.5, 1.0};
+#define JPDBManagerMetricsBucketCount (sizeof(JPDBManagerMetricsBounds) / sizeof(double) + 1)
+
+// Latency statistics of one Entity, or of the commits.
+@interface JPDBManagerMetricsSeries : NSObject {
+@public
+    NSUInteger count;
+    NSUInteger rows;
+    NSTimeInterval totalTime;
+    NSTimeInterval maxTime;
+    NSUInteger histogram[JPDBManagerMetricsBucketCount];
+}
+@end
+
+@implementation JPDBManagerMetricsSeries
+@end
+
+@interface JPDBManagerMetrics () {
+    NSMutableDictionary *_entities;
+    JPDBManagerMetricsSeries *_commits;
+    NSUInteger _inserted, _updated, _deleted;
+    NSMutableArray *_slowQueries;
+}
+@end
+
+@implementation JPDBManagerMetrics
+
+#pragma mark - Init Methods.
+- (id)init {
+    self = [super init];
+    if (self != nil) {
+        _slowQueryThreshold = JPDBManagerDefaultSlowQueryThreshold;
+        _slowQueryLogLimit = JPDBManagerDefaultSlowQueryLogSize;
+        [self reset];
+    }
+    return self;
+}
+
++ (NSArray *)histogramBounds {
+    NSMutableArray *bounds = [NSMutableArray arrayWithCapacity:JPDBManagerMetricsBucketCount - 1];
+    for (NSUInteger i = 0; i < JPDBManagerMetricsBucketCount - 1; i++)
+        [bounds addObject:@(JPDBManagerMetricsBounds[i])];
+
+    return bounds;
+}
+
+- (void)reset {
+    @synchronized (self) {
+        _entities = [NSMutableDictionary new];
+        _commits = [JPDBManagerMetricsSeries new];
+        _inserted = _updated = _deleted = 0;
+        _slowQueries = [NSMutableArray new];
+    }
+}
+
+
+
+
+#pragma mark - Private Methods.
+
+// Add one duration to the series. Must be called synchronized.
+- (void)addDuration:(NSTimeInterval)duration rows:(NSUInteger)rows toSeries:(JPDBManagerMetricsSeries *)series {
+    NSUInteger bucket = 0;
+    while (bucket < JPDBManagerMetricsBucketCount - 1 && duration > JPDBManagerMetricsBounds[bucket])
+        bucket++;
+
+    series->count++;
+    series->rows += rows;
+    series->totalTime += duration;
+    series->maxTime = MAX(series->maxTime, duration);
+    series->histogram[bucket]++;
+}
+
+- (NSDictionary *)dictionaryFromSeries:(JPDBManagerMetricsSeries *)series {
+    NSMutableArray *histogram = [NSMutableArray arrayWithCapacity:JPDBManagerMetricsBucketCount];
+    for (NSUInteger i = 0; i < JPDBManagerMetricsBucketCount; i++)
+        [histogram addObject:@(series->histogram[i])];
+
+    return @{
+            @"count"     : @(series->count),
+            @"rows"      : @(series->rows),
+            @"totalTime" : @(series->totalTime),
+            @"maxTime"   : @(series->maxTime),
+            @"histogram" : histogram
+    };
+}
+
+
+
+
+#pragma mark - Record Methods.
+- (void)recordQuery:(NSDictionary *)event {
+    NSString *entity = event[JPDBManagerMetricEntity] ?: @"";
+    NSTimeInterval duration = [event[JPDBManagerMetricDuration] doubleValue];
+    BOOL slow = duration >= self.slowQueryThreshold;
+
+    @synchronized (self) {
+        JPDBManagerMetricsSeries *series = _entities[entity];
+        if (!series) {
+            series = [JPDBManagerMetricsSeries new];
+            _entities[entity] = series;
+        }
+
+        [self addDuration:duration rows:[event[JPDBManagerMetricRows] unsignedIntegerValue] toSeries:series];
+
+        if (slow) {
+            [_slowQueries addObject:event];
+            if ([_slowQueries count] > self.slowQueryLogLimit)
+                [_slowQueries removeObjectsInRange:NSMakeRange(0, [_slowQueries count] - self.slowQueryLogLimit)];
+        }
+    }
+
+    if (slow && self.logSlowQueries)
+        NSLog(@"Slow Query (%.1f ms): %@", duration * 1000, event);
+}
+
+- (void)recordCommit:(NSDictionary *)event {
+    @synchronized (self) {
+        [self addDuration:[event[JPDBManagerMetricDuration] doubleValue] rows:0 toSeries:_commits];
+
+        _inserted += [event[JPDBManagerMetricInserted] unsignedIntegerValue];
+        _updated += [event[JPDBManagerMetricUpdated] unsignedIntegerValue];
+        _deleted += [event[JPDBManagerMetricDeleted] unsignedIntegerValue];
+    }
+}
+
+- (NSDictionary *)snapshot {
+    @synchronized (self) {
+        NSMutableDictionary *entities = [NSMutableDictionary dictionaryWithCapacity:[_entities count]];
+        [_entities enumerateKeysAndObjectsUsingBlock:^(NSString *name, JPDBManagerMetricsSeries *series, BOOL *stop) {
+            entities[name] = [self dictionaryFromSeries:series];
+        }];
+
+        NSMutableDictionary *commits = [[self dictionaryFromSeries:_commits] mutableCopy];
+        commits[JPDBManagerMetricInserted] = @(_inserted);
+        commits[JPDBManagerMetricUpdated] = @(_updated);
+        commits[JPDBManagerMetricDeleted] = @(_deleted);
+
+        return @{
+                @"entities"    : [entities copy],
+                @"commits"     : [commits copy],
+                @"slowQueries" : [_slowQueries copy]
+        };
+    }
+}
+
+@end
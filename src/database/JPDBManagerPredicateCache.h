@@ -0,0 +1,73 @@
+/*
+ * Created by Paulo Oliveira at 2011. JUMP version 2, Copyright (c) 2014 - seqoy.org and Paulo Oliveira ( http://www.seqoy.org )
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#import <Foundation/Foundation.h>
+
+/**
+ * \class JPDBManagerPredicateCache
+ * Thread safe cache of parsed predicates, keyed by format string.<br>
+ * Every <tt>%@</tt> of one format is replaced by an substitution variable and the format is parsed only once,
+ * later calls just bind the arguments on the cached template. Formats using other specifiers (<tt>%K</tt>,
+ * <tt>%d</tt>...), quotes or his own <tt>$variables</tt> can't be cached this way and are always parsed.<br>
+ * <br>
+ * The \link NSManagedObject(JPDatabase) NSManagedObject extension\endlink uses the #sharedCache to build
+ * the predicates of his <b>where:</b>, <b>find:</b> and <b>countWhere:</b> methods.
+ */
+@interface JPDBManagerPredicateCache : NSObject
+
+/**
+ * Maximum number of formats kept on the cache. Default is \ref JPDBManagerDefaultPredicateCacheSize.
+ */
+@property(nonatomic) NSUInteger countLimit;
+
+/**
+ * How many predicates were built from an cached template.
+ */
+@property(readonly) NSUInteger hits;
+
+/**
+ * How many formats were parsed and added to the cache.
+ */
+@property(readonly) NSUInteger misses;
+
+/**
+ * How many predicates were parsed because his format or arguments can't be cached.
+ */
+@property(readonly) NSUInteger bypasses;
+
+/**
+ * Shared cache instance.
+ */
++ (JPDBManagerPredicateCache *)sharedCache;
+
+/**
+ * Return an predicate for one format, binding the arguments on the cached template.
+ * @param format The predicate format string.
+ * @param arguments Arguments of the format.
+ */
+- (NSPredicate *)predicateWithFormat:(NSString *)format arguments:(va_list)arguments;
+
+/**
+ * Return an predicate matching all keys and values of one dictionary, caching one template for each set of keys.
+ * @param dict Keys and values to match.
+ */
+- (NSPredicate *)predicateMatchingDictionary:(NSDictionary *)dict;
+
+/**
+ * Remove all cached templates and reset the statistics.
+ */
+- (void)removeAllPredicates;
+
+@end
@@ -0,0 +1,215 @@
+/*
+ * Created by Paulo Oliveira at 2011. JUMP version 2, Copyright (c) 2014 - seqoy.org and Paulo Oliveira ( http://www.seqoy.org )
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#import <libkern/OSAtomic.h>
+#import "JPDBManagerPredicateCache.h"
+#import "JPDBManagerDefinitions.h"
+
+// Name of the substitution variables created for each argument.
+#define JPDBManagerPredicateVariable( __index ) [NSString stringWithFormat:@"JPArg%lu", (unsigned long) __index]
+
+@interface JPDBManagerPredicateCache () {
+    NSCache *_templates;
+
+    volatile int32_t _hits;
+    volatile int32_t _misses;
+    volatile int32_t _bypasses;
+}
+@end
+
+@implementation JPDBManagerPredicateCache
+
+#pragma mark - Init Methods.
++ (JPDBManagerPredicateCache *)sharedCache {
+    static JPDBManagerPredicateCache *sharedCache;
+    static dispatch_once_t onceToken;
+    dispatch_once(&onceToken, ^{
+        sharedCache = [self new];
+    });
+    return sharedCache;
+}
+
+- (id)init {
+    self = [super init];
+    if (self != nil) {
+        _templates = [NSCache new];
+        self.countLimit = JPDBManagerDefaultPredicateCacheSize;
+    }
+    return self;
+}
+
+- (void)setCountLimit:(NSUInteger)countLimit {
+    _countLimit = countLimit;
+    [_templates setCountLimit:countLimit];
+}
+
+
+
+
+#pragma mark - Statistics.
+- (NSUInteger)hits {
+    return (NSUInteger) _hits;
+}
+
+- (NSUInteger)misses {
+    return (NSUInteger) _misses;
+}
+
+- (NSUInteger)bypasses {
+    return (NSUInteger) _bypasses;
+}
+
+- (void)removeAllPredicates {
+    [_templates removeAllObjects];
+
+    _hits = 0;
+    _misses = 0;
+    _bypasses = 0;
+}
+
+
+
+
+#pragma mark - Private Methods.
+
+// Replace every %@ by an substitution variable. Return nil if the format can't be cached.
+- (NSString *)templateFormatFrom:(NSString *)format argumentsCount:(NSUInteger *)count {
+    NSMutableString *template = [NSMutableString stringWithCapacity:[format length] + 16];
+    NSUInteger variables = 0;
+    NSUInteger length = [format length];
+
+    for (NSUInteger i = 0; i < length; i++) {
+        unichar character = [format characterAtIndex:i];
+
+        // Quoted strings and user variables keep the original parsing.
+        if (character == '\'' || character == '"' || character == '$')
+            return nil;
+
+        if (character == '%') {
+
+            // Only object arguments can be bound as variables.
+            if (i + 1 >= length || [format characterAtIndex:i + 1] != '@')
+                return nil;
+
+            [template appendFormat:@"$%@", JPDBManagerPredicateVariable( variables )];
+            variables++;
+            i++;
+            continue;
+        }
+
+        [template appendFormat:@"%C", character];
+    }
+
+    *count = variables;
+    return template;
+}
+
+// Return the cached template of one format, parsing it if needed. NSNull means the format can't be cached.
+- (id)templateForFormat:(NSString *)format {
+    id template = [_templates objectForKey:format];
+    if (template)
+        return template;
+
+    NSUInteger count = 0;
+    NSString *templateFormat = [self templateFormatFrom:format argumentsCount:&count];
+
+    if (templateFormat) {
+        template = @[[NSPredicate predicateWithFormat:templateFormat argumentArray:nil], @(count)];
+        OSAtomicIncrement32Barrier(&_misses);
+    }
+    else {
+        template = [NSNull null];
+    }
+
+    [_templates setObject:template forKey:[format copy]];
+    return template;
+}
+
+// Bind the values on one template.
+- (NSPredicate *)predicate:(NSPredicate *)template withValues:(NSArray *)values {
+    if ([values count] == 0)
+        return template;
+
+    NSMutableDictionary *variables = [NSMutableDictionary dictionaryWithCapacity:[values count]];
+    [values enumerateObjectsUsingBlock:^(id value, NSUInteger index, BOOL *stop) {
+        variables[JPDBManagerPredicateVariable( index )] = value;
+    }];
+
+    return [template predicateWithSubstitutionVariables:variables];
+}
+
+
+
+
+#pragma mark - Predicate Methods.
+- (NSPredicate *)predicateWithFormat:(NSString *)format arguments:(va_list)arguments {
+    id template = [self templateForFormat:format];
+
+    if (template != [NSNull null]) {
+        NSUInteger count = [template[1] unsignedIntegerValue];
+
+        // Read the arguments from an copy, the original list is still needed if we can't bind them.
+        NSMutableArray *values = [NSMutableArray arrayWithCapacity:count];
+        if (count > 0 && arguments != NULL) {
+            va_list copy;
+            va_copy(copy, arguments);
+            for (NSUInteger i = 0; i < count; i++) {
+                id value = va_arg(copy, id);
+
+                // Nil arguments doesn't fit on variables.
+                if (value == nil)
+                    break;
+
+                [values addObject:value];
+            }
+            va_end(copy);
+        }
+
+        if ([values count] == count) {
+            OSAtomicIncrement32Barrier(&_hits);
+            return [self predicate:template[0] withValues:values];
+        }
+    }
+
+    OSAtomicIncrement32Barrier(&_bypasses);
+    return [NSPredicate predicateWithFormat:format arguments:arguments];
+}
+
+- (NSPredicate *)predicateMatchingDictionary:(NSDictionary *)dict {
+    NSArray *keys = [[dict allKeys] sortedArrayUsingSelector:@selector(compare:)];
+
+    // Keys are part of the format, the cache key is the sorted set of keys.
+    NSString *cacheKey = [@"{dictionary}" stringByAppendingString:[keys componentsJoinedByString:@"\x1F"]];
+
+    NSPredicate *template = [_templates objectForKey:cacheKey];
+    if (template) {
+        OSAtomicIncrement32Barrier(&_hits);
+    }
+    else {
+        NSMutableArray *subpredicates = [NSMutableArray arrayWithCapacity:[keys count]];
+        [keys enumerateObjectsUsingBlock:^(id key, NSUInteger index, BOOL *stop) {
+            NSString *format = [NSString stringWithFormat:@"%%K == $%@", JPDBManagerPredicateVariable( index )];
+            [subpredicates addObject:[NSPredicate predicateWithFormat:format, key]];
+        }];
+        template = [NSCompoundPredicate andPredicateWithSubpredicates:subpredicates];
+
+        [_templates setObject:template forKey:cacheKey];
+        OSAtomicIncrement32Barrier(&_misses);
+    }
+
+    return [self predicate:template withValues:[dict objectsForKeys:keys notFoundMarker:[NSNull null]]];
+}
+
+@end
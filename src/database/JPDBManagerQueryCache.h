@@ -0,0 +1,99 @@
+/*
+ * Created by Paulo Oliveira at 2011. JUMP version 2, Copyright (c) 2014 - seqoy.org and Paulo Oliveira ( http://www.seqoy.org )
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#import <Foundation/Foundation.h>
+#import <CoreData/CoreData.h>
+
+/**
+ * \class JPDBManagerQueryCache
+ * Cache of query results, stored as Object IDs.<br>
+ * Queries are identified by a canonical form of his Entity, predicate, sort descriptors, offset and limit.
+ * Every <b>NSManagedObjectContextDidSaveNotification</b> of the coordinator invalidates the results of the Entities
+ * it changed, including the results of his super entities, and of the queries reaching them by relationship key paths,
+ * like <tt>customer.name</tt>. Queries using subqueries or block predicates aren't cached.
+ * Memory is bounded by #countLimit and #objectIDsLimit.<br>
+ * <br>
+ * The \link JPDBManager Database Manager\endlink uses one cache when JPDBManager::enableQueryCache is set,
+ * you usually doesn't need to use this class directly.
+ */
+@interface JPDBManagerQueryCache : NSObject
+
+/**
+ * Maximum number of cached queries. Default is \ref JPDBManagerDefaultQueryCacheSize.
+ */
+@property(nonatomic) NSUInteger countLimit;
+
+/**
+ * Maximum number of Object IDs stored by all cached queries. Default is \ref JPDBManagerDefaultQueryCacheObjectIDs.
+ */
+@property(nonatomic) NSUInteger objectIDsLimit;
+
+/**
+ * How many queries were answered by the cache.
+ */
+@property(readonly) NSUInteger hits;
+
+/**
+ * How many cacheable queries went to the store.
+ */
+@property(readonly) NSUInteger misses;
+
+/**
+ * Ratio of the queries answered by the cache, from 0 to 1.
+ */
+@property(readonly) double hitRatio;
+
+/**
+ * Init the cache, invalidating his results with the saves of one coordinator.
+ * @param anCoordinator The Persistent Store Coordinator whose saves invalidate the results.
+ */
++ (id)initWithCoordinator:(NSPersistentStoreCoordinator *)anCoordinator;
+
+/**
+ * Init the cache, invalidating his results with the saves of one coordinator.
+ * @param anCoordinator The Persistent Store Coordinator whose saves invalidate the results.
+ */
+- (id)initWithCoordinator:(NSPersistentStoreCoordinator *)anCoordinator;
+
+/**
+ * Canonical key of one query, valid until the Entity of the query, or one Entity reached by his key paths, is changed.
+ * Take the key before executing the query, so a save performed meanwhile invalidates the stored result.
+ * @return The key, or <tt>nil</tt> if this query can't be cached.
+ */
+- (id)keyForRequest:(NSFetchRequest *)request;
+
+/**
+ * Return the Object IDs cached for one key, or <tt>nil</tt> if isn't cached.
+ */
+- (NSArray *)objectIDsForKey:(id)key;
+
+/**
+ * Store the result of one query.
+ * @param objects The records returned by the query.
+ * @param key The key returned by #keyForRequest: before the query was executed.
+ */
+- (void)storeObjects:(NSArray *)objects forKey:(id)key;
+
+/**
+ * Invalidate the cached results of one Entity and his super entities.
+ */
+- (void)invalidateEntity:(NSEntityDescription *)entity;
+
+/**
+ * Remove all cached results and reset the statistics.
+ */
+- (void)removeAllResults;
+
+@end
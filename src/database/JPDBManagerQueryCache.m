@@ -0,0 +1,289 @@
+/*
+ * Created by Paulo Oliveira at 2011. JUMP version 2, Copyright (c) 2014 - seqoy.org and Paulo Oliveira ( http://www.seqoy.org )
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#import <libkern/OSAtomic.h>
+#import "JPDBManagerQueryCache.h"
+#import "JPDBManagerDefinitions.h"
+
+@interface JPDBManagerQueryCache () {
+    NSCache *_results;
+
+    // Entity name -> Generation. Changing an Entity starts a new generation, which is part of the keys.
+    NSMutableDictionary *_generations;
+
+    __weak NSPersistentStoreCoordinator *_coordinator;
+
+    volatile int32_t _hits;
+    volatile int32_t _misses;
+}
+@end
+
+@implementation JPDBManagerQueryCache
+
+#pragma mark - Init Methods.
++ (id)initWithCoordinator:(NSPersistentStoreCoordinator *)anCoordinator {
+    return [[self alloc] initWithCoordinator:anCoordinator];
+}
+
+- (id)initWithCoordinator:(NSPersistentStoreCoordinator *)anCoordinator {
+    self = [super init];
+    if (self != nil) {
+        _results = [NSCache new];
+        _generations = [NSMutableDictionary new];
+        _coordinator = anCoordinator;
+
+        self.countLimit = JPDBManagerDefaultQueryCacheSize;
+        self.objectIDsLimit = JPDBManagerDefaultQueryCacheObjectIDs;
+
+        // Contexts can be created anytime, observe all saves and filter by coordinator.
+        [[NSNotificationCenter defaultCenter] addObserver:self
+                                                 selector:@selector(contextDidSave:)
+                                                     name:NSManagedObjectContextDidSaveNotification
+                                                   object:nil];
+    }
+    return self;
+}
+
+- (void)dealloc {
+    [[NSNotificationCenter defaultCenter] removeObserver:self];
+}
+
+- (void)setCountLimit:(NSUInteger)countLimit {
+    _countLimit = countLimit;
+    [_results setCountLimit:countLimit];
+}
+
+- (void)setObjectIDsLimit:(NSUInteger)objectIDsLimit {
+    _objectIDsLimit = objectIDsLimit;
+    [_results setTotalCostLimit:objectIDsLimit];
+}
+
+
+
+
+#pragma mark - Statistics.
+- (NSUInteger)hits {
+    return (NSUInteger) _hits;
+}
+
+- (NSUInteger)misses {
+    return (NSUInteger) _misses;
+}
+
+- (double)hitRatio {
+    double total = (double) _hits + _misses;
+    return total > 0 ? (double) _hits / total : 0;
+}
+
+
+
+
+#pragma mark - Entities of One Query.
+
+// Add the Entities reached by one key path. Return NO if the key path can't be followed.
+- (BOOL)addEntitiesOfKeyPath:(NSString *)keyPath fromEntity:(NSEntityDescription *)entity to:(NSMutableSet *)entities {
+    for (NSString *key in [keyPath componentsSeparatedByString:@"."]) {
+
+        // Collection operators, like @count, work on the last relationship.
+        if ([key hasPrefix:@"@"] || [key isEqualToString:@"self"])
+            continue;
+
+        NSRelationshipDescription *relationship = entity.relationshipsByName[key];
+        if (relationship) {
+            entity = relationship.destinationEntity;
+            [entities addObject:entity.name];
+            continue;
+        }
+
+        // Attributes ends the path, anything else, like fetched properties, can't be followed.
+        return entity.attributesByName[key] != nil;
+    }
+    return YES;
+}
+
+- (BOOL)addEntitiesOfExpression:(NSExpression *)expression fromEntity:(NSEntityDescription *)entity to:(NSMutableSet *)entities {
+    switch (expression.expressionType) {
+        case NSConstantValueExpressionType:
+        case NSEvaluatedObjectExpressionType:
+        case NSVariableExpressionType:
+            return YES;
+
+        case NSKeyPathExpressionType:
+            return [self addEntitiesOfKeyPath:expression.keyPath fromEntity:entity to:entities];
+
+        case NSFunctionExpressionType:
+            if (![self addEntitiesOfExpression:expression.operand fromEntity:entity to:entities])
+                return NO;
+            for (NSExpression *argument in expression.arguments) {
+                if (![self addEntitiesOfExpression:argument fromEntity:entity to:entities])
+                    return NO;
+            }
+            return YES;
+
+        case NSAggregateExpressionType:
+            for (NSExpression *element in expression.collection) {
+                if (![self addEntitiesOfExpression:element fromEntity:entity to:entities])
+                    return NO;
+            }
+            return YES;
+
+        case NSUnionSetExpressionType:
+        case NSIntersectSetExpressionType:
+        case NSMinusSetExpressionType:
+            return [self addEntitiesOfExpression:expression.leftExpression fromEntity:entity to:entities]
+                    && [self addEntitiesOfExpression:expression.rightExpression fromEntity:entity to:entities];
+
+            // Subqueries, blocks and any other expression aren't followed.
+        default:
+            return NO;
+    }
+}
+
+- (BOOL)addEntitiesOfPredicate:(NSPredicate *)predicate fromEntity:(NSEntityDescription *)entity to:(NSMutableSet *)entities {
+    if ([predicate isKindOfClass:[NSCompoundPredicate class]]) {
+        for (NSPredicate *subpredicate in [(NSCompoundPredicate *) predicate subpredicates]) {
+            if (![self addEntitiesOfPredicate:subpredicate fromEntity:entity to:entities])
+                return NO;
+        }
+        return YES;
+    }
+
+    if ([predicate isKindOfClass:[NSComparisonPredicate class]]) {
+        NSComparisonPredicate *comparison = (NSComparisonPredicate *) predicate;
+        return [self addEntitiesOfExpression:comparison.leftExpression fromEntity:entity to:entities]
+                && [self addEntitiesOfExpression:comparison.rightExpression fromEntity:entity to:entities];
+    }
+
+    // TRUEPREDICATE and FALSEPREDICATE, any other kind of predicate isn't followed.
+    NSString *format = [predicate predicateFormat];
+    return !predicate || [format isEqualToString:@"TRUEPREDICATE"] || [format isEqualToString:@"FALSEPREDICATE"];
+}
+
+// Names of every Entity whose changes can change the result of one query, or nil if they can't be known.
+- (NSSet *)entitiesOfRequest:(NSFetchRequest *)request {
+    NSEntityDescription *entity = request.entity;
+    NSMutableSet *entities = [NSMutableSet setWithObject:entity.name];
+
+    if (![self addEntitiesOfPredicate:request.predicate fromEntity:entity to:entities])
+        return nil;
+
+    for (NSSortDescriptor *sort in request.sortDescriptors) {
+        if (![self addEntitiesOfKeyPath:sort.key fromEntity:entity to:entities])
+            return nil;
+    }
+
+    return entities;
+}
+
+
+
+
+#pragma mark - Cache Methods.
+- (id)keyForRequest:(NSFetchRequest *)request {
+
+    // Only managed objects can be rebuilt from his Object IDs.
+    if (request.resultType != NSManagedObjectResultType || !request.entity)
+        return nil;
+
+    // Queries following relationships are also changed by the Entities they reach.
+    NSSet *entities = [self entitiesOfRequest:request];
+    if (!entities)
+        return nil;
+
+    NSMutableString *key = [NSMutableString stringWithCapacity:128];
+
+    @synchronized (_generations) {
+        for (NSString *name in [[entities allObjects] sortedArrayUsingSelector:@selector(compare:)])
+            [key appendFormat:@"%@#%@,", name, _generations[name] ?: @0];
+    }
+
+    [key appendFormat:@"|%@|%lu|%lu|%d", request.predicate.predicateFormat ?: @"",
+                      (unsigned long) request.fetchOffset, (unsigned long) request.fetchLimit,
+                      request.includesSubentities];
+
+    for (NSSortDescriptor *sort in request.sortDescriptors)
+        [key appendFormat:@"|%@:%d:%@", sort.key, sort.ascending, NSStringFromSelector(sort.selector)];
+
+    return key;
+}
+
+- (NSArray *)objectIDsForKey:(id)key {
+    // Queries that can't be cached aren't misses.
+    if (!key)
+        return nil;
+
+    NSArray *objectIDs = [_results objectForKey:key];
+
+    if (objectIDs)
+        OSAtomicIncrement32Barrier(&_hits);
+    else
+        OSAtomicIncrement32Barrier(&_misses);
+
+    return objectIDs;
+}
+
+- (void)storeObjects:(NSArray *)objects forKey:(id)key {
+    if (!key || !objects)
+        return;
+
+    NSArray *objectIDs = [objects valueForKey:@"objectID"];
+
+    // Results of objects not saved yet can't be reused.
+    for (NSManagedObjectID *objectID in objectIDs) {
+        if ([objectID isTemporaryID])
+            return;
+    }
+
+    [_results setObject:objectIDs forKey:key cost:MAX([objectIDs count], 1)];
+}
+
+- (void)invalidateEntity:(NSEntityDescription *)entity {
+    @synchronized (_generations) {
+
+        // Queries on super entities also return the records of this one.
+        for (NSEntityDescription *current = entity; current; current = current.superentity)
+            _generations[current.name] = @([_generations[current.name] unsignedIntegerValue] + 1);
+    }
+}
+
+- (void)removeAllResults {
+    [_results removeAllObjects];
+
+    _hits = 0;
+    _misses = 0;
+}
+
+
+
+
+#pragma mark - Notifications.
+- (void)contextDidSave:(NSNotification *)notification {
+    NSManagedObjectContext *context = notification.object;
+
+    // Only saves of our coordinator.
+    if (context.persistentStoreCoordinator != _coordinator)
+        return;
+
+    NSMutableSet *entities = [NSMutableSet set];
+    for (NSString *changes in @[NSInsertedObjectsKey, NSUpdatedObjectsKey, NSDeletedObjectsKey]) {
+        for (NSManagedObject *object in notification.userInfo[changes])
+            [entities addObject:object.entity];
+    }
+
+    for (NSEntityDescription *entity in entities)
+        [self invalidateEntity:entity];
+}
+
+@end
@@ -0,0 +1,123 @@
+/*
+ * Created by Paulo Oliveira at 2011. JUMP version 2, Copyright (c) 2014 - seqoy.org and Paulo Oliveira ( http://www.seqoy.org )
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#import <Foundation/Foundation.h>
+#import <CoreData/CoreData.h>
+
+/**
+ * \class JPDBManagerStoreConfiguration
+ * Describe how the \link JPDBManager Database Manager\endlink opens his Persistent Store: the store type and location,
+ * if it is read-only, and the SQLite pragmas used to tune his I/O. Pass one configuration to
+ * JPDBManager::startCoreDataWithConfiguration: or set JPDBManager::storeConfiguration before starting the Core Data.<br>
+ * <br>
+ * Ready to use profiles are available by name with #configurationNamed:, and the application can register his own
+ * profiles with #registerConfiguration:named:, so each deployment is tuned by choosing one name.
+ */
+@interface JPDBManagerStoreConfiguration : NSObject <NSCopying>
+
+/**
+ * Type of the store, like <b>NSSQLiteStoreType</b> or <b>NSInMemoryStoreType</b>. Default is <b>NSSQLiteStoreType</b>.
+ */
+@property(copy) NSString *storeType;
+
+/**
+ * Where the store is located. Default is <tt>nil</tt>, that means JPDBManager::SQLiteFilePath for SQLite stores.
+ * Ignored by in-memory stores.
+ */
+@property(copy) NSURL *storeURL;
+
+/**
+ * Set as 'YES' to open the store read-only. Commits fail on read-only stores. Default value is <b>NO</b>.
+ */
+@property(assign) BOOL readOnly;
+
+/**
+ * Set as 'YES' to migrate the store automatically, inferring the mapping model. Default value is <b>YES</b>.
+ */
+@property(assign) BOOL automaticMigration;
+
+/**
+ * SQLite journal mode, like <b>WAL</b>, <b>DELETE</b> or <b>TRUNCATE</b>. Default is <tt>nil</tt>, the Core Data default.
+ */
+@property(copy) NSString *journalMode;
+
+/**
+ * SQLite synchronous level: <b>OFF</b>, <b>NORMAL</b> or <b>FULL</b>. Default is <tt>nil</tt>, the Core Data default.
+ */
+@property(copy) NSString *synchronous;
+
+/**
+ * SQLite page cache size. Positive values are pages, negative values are KiB as on the SQLite <b>cache_size</b> pragma.
+ * Default is <b>0</b>, the SQLite default.
+ */
+@property(assign) NSInteger cacheSize;
+
+/**
+ * Bytes of the store that SQLite maps on memory. Default is <b>0</b>, no memory mapping.
+ * Memory mapped I/O needs SQLite 3.7.17, shipped since iOS 8. Older versions ignore this pragma.
+ */
+@property(assign) unsigned long long mmapSize;
+
+/**
+ * Any other SQLite pragma, by name. Applied after the pragmas above, so they can override them.
+ */
+@property(copy) NSDictionary *pragmas;
+
+/**
+ * Create one configuration with the default values: an SQLite store on JPDBManager::SQLiteFilePath,
+ * with automatic migration.
+ */
++ (id)init;
+
+/**
+ * Create one configuration for one store type. See #storeType.
+ */
++ (id)initWithStoreType:(NSString *)anStoreType;
+
+/**
+ * Create one configuration for one store type. See #storeType.
+ */
+- (id)initWithStoreType:(NSString *)anStoreType;
+
+/**
+ * One registered profile, like \ref JPDBManagerStoreProfileWriteHeavy. Return one copy, that can be changed freely.
+ * Profiles defined on JPDBManagerDefinitions.h are always registered:<br>
+ * - \ref JPDBManagerStoreProfileDefault: same as #init.
+ * - \ref JPDBManagerStoreProfileWriteHeavy: WAL journal and <b>NORMAL</b> synchronous level, commits doesn't wait
+ *   the disk flush of every transaction.
+ * - \ref JPDBManagerStoreProfileReadHeavy: WAL journal and bigger page cache. Set #mmapSize on one copy to also
+ *   map the store on memory, where the SQLite supports it.
+ * - \ref JPDBManagerStoreProfileInMemory: in-memory store, for caches and tests.
+ * .
+ * @return The profile, or <tt>nil</tt> if there is no profile with this name.
+ */
++ (id)configurationNamed:(NSString *)anName;
+
+/**
+ * Register one profile, replacing any profile with the same name. The configuration is copied.
+ */
++ (void)registerConfiguration:(JPDBManagerStoreConfiguration *)anConfiguration named:(NSString *)anName;
+
+/**
+ * SQLite pragmas defined by this configuration, as expected by <b>NSSQLitePragmasOption</b>.
+ */
+- (NSDictionary *)sqlitePragmas;
+
+/**
+ * Options to add the store to one Persistent Store Coordinator.
+ */
+- (NSDictionary *)storeOptions;
+
+@end
@@ -0,0 +1,150 @@
+/*
+ * Created by Paulo Oliveira at 2011. JUMP version 2, Copyright (c) 2014 - seqoy.org and Paulo Oliveira ( http://www.seqoy.org )
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#import "JPDBManagerStoreConfiguration.h"
+#import "JPDBManagerDefinitions.h"
+
+@implementation JPDBManagerStoreConfiguration
+
+#pragma mark - Init Methods.
++ (id)init {
+    return [[self alloc] init];
+}
+
++ (id)initWithStoreType:(NSString *)anStoreType {
+    return [[self alloc] initWithStoreType:anStoreType];
+}
+
+- (id)init {
+    return [self initWithStoreType:NSSQLiteStoreType];
+}
+
+- (id)initWithStoreType:(NSString *)anStoreType {
+    self = [super init];
+    if (self != nil) {
+        _storeType = [anStoreType copy];
+        _automaticMigration = YES;
+    }
+    return self;
+}
+
+- (id)copyWithZone:(NSZone *)zone {
+    JPDBManagerStoreConfiguration *copy = [[[self class] allocWithZone:zone] initWithStoreType:self.storeType];
+
+    copy.storeURL = self.storeURL;
+    copy.readOnly = self.readOnly;
+    copy.automaticMigration = self.automaticMigration;
+    copy.journalMode = self.journalMode;
+    copy.synchronous = self.synchronous;
+    copy.cacheSize = self.cacheSize;
+    copy.mmapSize = self.mmapSize;
+    copy.pragmas = self.pragmas;
+
+    return copy;
+}
+
+
+
+
+#pragma mark - Profiles Methods.
+
+// Registered profiles, by name.
++ (NSMutableDictionary *)profiles {
+    static NSMutableDictionary *profiles = nil;
+    static dispatch_once_t onceToken;
+
+    dispatch_once(&onceToken, ^{
+        JPDBManagerStoreConfiguration *writeHeavy = [self init];
+        writeHeavy.journalMode = @"WAL";
+        writeHeavy.synchronous = @"NORMAL";
+
+        JPDBManagerStoreConfiguration *readHeavy = [self init];
+        readHeavy.journalMode = @"WAL";
+        readHeavy.cacheSize = -8192;
+
+        profiles = [@{
+                JPDBManagerStoreProfileDefault    : [self init],
+                JPDBManagerStoreProfileWriteHeavy : writeHeavy,
+                JPDBManagerStoreProfileReadHeavy  : readHeavy,
+                JPDBManagerStoreProfileInMemory   : [self initWithStoreType:NSInMemoryStoreType]
+        } mutableCopy];
+    });
+
+    return profiles;
+}
+
++ (id)configurationNamed:(NSString *)anName {
+    NSMutableDictionary *profiles = [self profiles];
+
+    @synchronized (profiles) {
+        return [profiles[anName] copy];
+    }
+}
+
++ (void)registerConfiguration:(JPDBManagerStoreConfiguration *)anConfiguration named:(NSString *)anName {
+    NSMutableDictionary *profiles = [self profiles];
+
+    @synchronized (profiles) {
+        profiles[anName] = [anConfiguration copy];
+    }
+}
+
+
+
+
+#pragma mark - Options Methods.
+- (NSDictionary *)sqlitePragmas {
+    NSMutableDictionary *pragmas = [NSMutableDictionary dictionary];
+
+    if (self.journalMode)
+        pragmas[@"journal_mode"] = self.journalMode;
+
+    if (self.synchronous)
+        pragmas[@"synchronous"] = self.synchronous;
+
+    if (self.cacheSize != 0)
+        pragmas[@"cache_size"] = [@(self.cacheSize) stringValue];
+
+    if (self.mmapSize > 0)
+        pragmas[@"mmap_size"] = [@(self.mmapSize) stringValue];
+
+    if (self.pragmas)
+        [pragmas addEntriesFromDictionary:self.pragmas];
+
+    return pragmas;
+}
+
+- (NSDictionary *)storeOptions {
+    NSMutableDictionary *options = [NSMutableDictionary dictionary];
+
+    if (self.automaticMigration) {
+        options[NSMigratePersistentStoresAutomaticallyOption] = @YES;
+
+        // Attempt to create the mapping model automatically.
+        options[NSInferMappingModelAutomaticallyOption] = @YES;
+    }
+
+    if (self.readOnly)
+        options[NSReadOnlyPersistentStoreOption] = @YES;
+
+    // Pragmas only make sense to SQLite.
+    NSDictionary *pragmas = [self sqlitePragmas];
+    if ([self.storeType isEqualToString:NSSQLiteStoreType] && [pragmas count] > 0)
+        options[NSSQLitePragmasOption] = pragmas;
+
+    return options;
+}
+
+@end
@@ -17,6 +17,7 @@
 #import <CoreData/CoreData.h>
 
 @class JPDBManagerAction;
+@class JPDBManagerAsyncQuery;
 
 /**
  * This category extends NSManagedObject adding an set of convenient helper methods for basic operations.
@@ -38,14 +39,45 @@
 
 /**
  * Count how many object this entity has.
+ * The count is performed by the persistent store, no object is loaded.
  */
 + (NSUInteger)count;
 
 /**
  * Count how many object this entity has, based on some specific query.
+ * The count is performed by the persistent store, no object is loaded.
  */
 + (NSUInteger)countWhere:(id)condition, ...;
 
+/**
+ * Count how many distinct values of one attribute this entity has.
+ */
++ (NSUInteger)countDistinct:(NSString *)anKey;
+
+/**
+ * Sum the values of one attribute of this entity.
+ * @return The sum or <tt>nil</tt> if this entity is empty.
+ */
++ (NSNumber *)sumOf:(NSString *)anKey;
+
+/**
+ * Minimum value of one attribute of this entity.
+ * @return The minimum value or <tt>nil</tt> if this entity is empty.
+ */
++ (id)minOf:(NSString *)anKey;
+
+/**
+ * Maximum value of one attribute of this entity.
+ * @return The maximum value or <tt>nil</tt> if this entity is empty.
+ */
++ (id)maxOf:(NSString *)anKey;
+
+/**
+ * Average of the values of one attribute of this entity.
+ * @return The average or <tt>nil</tt> if this entity is empty.
+ */
++ (NSNumber *)averageOf:(NSString *)anKey;
+
 //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// ////
 #pragma mark -
 #pragma mark Query Data Methods.
@@ -88,6 +120,21 @@
  */
 + (id)where:(id)condition, ...;
 
+/**
+ * Query all data of this Entity on background. See JPDBManagerAction::runAsync:.
+ * @param completion Block called on the main queue with the records, fetched into the main context.
+ * @return An handle to cancel the query.
+ */
++ (JPDBManagerAsyncQuery *)allAsync:(void (^)(NSArray *result))completion;
+
+/**
+ * Query this Entity using one specific query on background. See JPDBManagerAction::runAsync:.
+ * @param completion Block called on the main queue with the records, fetched into the main context.
+ * @param condition An query condition that will create an NSPredicate to perform.
+ * @return An handle to cancel the query.
+ */
++ (JPDBManagerAsyncQuery *)whereAsync:(void (^)(NSArray *result))completion condition:(id)condition, ...;
+
 /**
  * Query this Entity using one specific query and ordering by some key.
  * @param anKey One Key attribute to sort the result.
@@ -104,6 +151,66 @@
  */
 + (instancetype)find:(id)condition, ...;
 
+/**
+ * Return an action that prefetch some Relationships of this Entity, configure it further and run it.
+ * See JPDBManagerAction::applyPrefetchRelationships:.
+ * \code
+ * NSArray *orders = [[[Order includes:@[@"customer", @"items"]] applyPredicate:predicate] run];
+ * \endcode
+ * @param keyPaths One Relationship name or key path, or an Array of them.
+ * @return The \link JPDBManagerAction Database Action\endlink configured.
+ */
++ (JPDBManagerAction *)includes:(id)keyPaths;
+
+/**
+ * Query only some properties of all records of this Entity, without creating any Managed Object.
+ * @param keys One property name, or an Array of property names.
+ * @return An Array with the values of the property, or an Array of dictionaries if more properties were passed.
+ */
++ (NSArray *)pluck:(id)keys;
+
+/**
+ * Query only some properties of this Entity using one specific query. See #pluck:.
+ * @param keys One property name, or an Array of property names.
+ * @param condition An query condition that will create an NSPredicate to perform.
+ * @return An Array with the values of the property, or an Array of dictionaries if more properties were passed.
+ */
++ (NSArray *)pluck:(id)keys where:(id)condition, ...;
+
+/**
+ * Find this Entity by one unique Key Attribute. Objects already found are returned from an in-memory index
+ * without going to the store, see JPDBManagerAction::queryRecordWithKey:value:.
+ * @param anKey One Key attribute whose values are unique on this Entity.
+ * @param value The value to match.
+ * @return The object found or <tt>nil</tt>.
+ */
++ (instancetype)findByKey:(NSString *)anKey value:(id)value;
+
+///@}
+//// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// ////
+#pragma mark -
+#pragma mark Batch Enumeration Methods.
+//// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// ////
+/** @name Batch Enumeration Methods
+ */
+///@{
+
+/**
+ * Enumerate all data of this Entity in fixed size batches, keeping the memory flat on large Entities.
+ * See JPDBManagerAction::enumerateInBatchesOfSize:usingBlock: for more information.
+ * @param batchSize How many records each batch should have. Pass 0 to use the default size.
+ * @param block Block called for every batch. Set <tt>*stop</tt> to <b>YES</b> to stop the enumeration.
+ */
++ (void)enumerateInBatchesOfSize:(NSUInteger)batchSize usingBlock:(void (^)(NSArray *batch, BOOL *stop))block;
+
+/**
+ * Enumerate the data of this Entity that match one specific query in fixed size batches.
+ * @param condition An NSPredicate or an NSDictionary of keys and values to match.
+ * @param batchSize How many records each batch should have. Pass 0 to use the default size.
+ * @param block Block called for every batch. Set <tt>*stop</tt> to <b>YES</b> to stop the enumeration.
+ */
++ (void)enumerateWhere:(id)condition inBatchesOfSize:(NSUInteger)batchSize usingBlock:(void (^)(NSArray *batch, BOOL *stop))block;
+
 ///@}
 //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// ////
 #pragma mark -
@@ -125,9 +232,10 @@
 
 /**
  * Delete all objects from this Entity.
- * This could be a consuming time operation on large databases.
+ * Objects are deleted in bounded batches without being loaded, see JPDBManagerAction::deleteRecordsInBatchesOfSize:.
+ * @return How many objects was deleted.
  */
-+ (void)deleteAll;
++ (NSUInteger)deleteAll;
 
 ///@}
 //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// //// ////
@@ -144,6 +252,21 @@
  */
 + (instancetype)create;
 
+/**
+ * Import objects to this Entity from an NSArray or an NSEnumerator of dictionaries.
+ * See JPDBManagerAction::importRecords:inBatchesOfSize:progress: for more information.
+ * @return How many objects was imported.
+ */
++ (NSUInteger)importRecords:(id)records;
+
+/**
+ * Import objects to this Entity from an NSArray or an NSEnumerator of dictionaries, in batches of
+ * specified size reporting the progress. See JPDBManagerAction::importRecords:inBatchesOfSize:progress: for more information.
+ * @return How many objects was imported.
+ */
++ (NSUInteger)importRecords:(id)records inBatchesOfSize:(NSUInteger)batchSize
+                   progress:(void (^)(NSUInteger importedCount, double recordsPerSecond, BOOL *stop))progress;
+
 /**
  * Commit unsaved changes on pending objects of this instance.
  * An JPDBManagerErrorNotification notification will be posted in any error.
@@ -17,6 +17,8 @@
 #import "JPDBManagerDefinitions.h"
 #import "JPDBManagerSingleton.h"
 #import "JPDBManagerAction.h"
+#import "JPDBManagerPredicateCache.h"
+#import "JPDBManagerAsyncQuery.h"
 
 #define JPBuildPredicate( __anPredicate  ) \
                                 va_list va_arguments;\
@@ -61,14 +63,23 @@
     [[self class] save];
 }
 
-+ (void)deleteAll {
-    [[self getAction] deleteAllRecords];
++ (NSUInteger)deleteAll {
+    return [[self getAction] deleteAllRecords];
 }
 
 + (instancetype)create {
     return [[self getAction] createNewRecord];
 }
 
++ (NSUInteger)importRecords:(id)records {
+    return [[self getAction] importRecords:records];
+}
+
++ (NSUInteger)importRecords:(id)records inBatchesOfSize:(NSUInteger)batchSize
+                   progress:(void (^)(NSUInteger importedCount, double recordsPerSecond, BOOL *stop))progress {
+    return [[self getAction] importRecords:records inBatchesOfSize:batchSize progress:progress];
+}
+
 + (NSArray *)all {
     return [[[self getAction] all] run];
 }
@@ -103,6 +114,16 @@
     return [[[self getAction] applyPredicate:anPredicate] run];
 }
 
++ (JPDBManagerAsyncQuery *)allAsync:(void (^)(NSArray *result))completion {
+    return [[[self getAction] all] runAsync:completion];
+}
+
++ (JPDBManagerAsyncQuery *)whereAsync:(void (^)(NSArray *result))completion condition:(id)condition, ... {
+    JPBuildPredicate( anPredicate );
+
+    return [[[self getAction] applyPredicate:anPredicate] runAsync:completion];
+}
+
 + (id)usingOrder:(NSString *)order where:(id)condition, ... {
     JPBuildPredicate( anPredicate );
 
@@ -112,7 +133,11 @@
 + (instancetype)find:(id)condition, ... {
     JPBuildPredicate( anPredicate );
 
-    id data = [[[self getAction] applyPredicate:anPredicate] run];
+    // Only the first record is needed, don't let the store materialize every match.
+    JPDBManagerAction *action = [[self getAction] applyPredicate:anPredicate];
+    [action setFetchOffset:0 setFetchLimit:1];
+
+    id data = [action run];
 
     // If found nothing, return nil.
     if (!data || [data count] == 0)
@@ -122,26 +147,81 @@
     return data[0];
 }
 
++ (JPDBManagerAction *)includes:(id)keyPaths {
+    if ([keyPaths isKindOfClass:[NSString class]])
+        keyPaths = @[keyPaths];
+
+    return [[[self getAction] all] applyPrefetchRelationships:keyPaths];
+}
+
++ (NSArray *)pluck:(id)keys {
+    return [self pluck:keys fromAction:[[self getAction] all]];
+}
+
++ (NSArray *)pluck:(id)keys where:(id)condition, ... {
+    JPBuildPredicate( anPredicate );
+
+    return [self pluck:keys fromAction:[[self getAction] applyPredicate:anPredicate]];
+}
+
++ (NSArray *)pluck:(id)keys fromAction:(JPDBManagerAction *)action {
+
+    // One key return his values.
+    if ([keys isKindOfClass:[NSString class]])
+        return [action queryValuesOfKey:keys distinct:NO];
+
+    // More keys return dictionaries.
+    return [[action applyPropertiesToFetch:keys] run];
+}
+
++ (instancetype)findByKey:(NSString *)anKey value:(id)value {
+    return [[self getAction] queryRecordWithKey:anKey value:value];
+}
+
++ (void)enumerateInBatchesOfSize:(NSUInteger)batchSize usingBlock:(void (^)(NSArray *batch, BOOL *stop))block {
+    [[[self getAction] all] enumerateInBatchesOfSize:batchSize usingBlock:block];
+}
+
++ (void)enumerateWhere:(id)condition inBatchesOfSize:(NSUInteger)batchSize usingBlock:(void (^)(NSArray *batch, BOOL *stop))block {
+    NSPredicate *anPredicate = [self predicateFromObject:condition];
+
+    [[[self getAction] applyPredicate:anPredicate] enumerateInBatchesOfSize:batchSize usingBlock:block];
+}
+
 + (NSUInteger)count {
-    return [[self all] count];
+    return [[[self getAction] all] countRecords];
 }
 
 + (NSUInteger)countWhere:(id)condition, ... {
     JPBuildPredicate( anPredicate );
 
-    return [[[[self getAction] applyPredicate:anPredicate] run] count];
+    return [[[self getAction] applyPredicate:anPredicate] countRecords];
+}
+
++ (NSUInteger)countDistinct:(NSString *)anKey {
+    return [[[self getAction] all] countDistinctKey:anKey];
+}
+
++ (NSNumber *)sumOf:(NSString *)anKey {
+    return [[[self getAction] all] sumOfKey:anKey];
+}
+
++ (id)minOf:(NSString *)anKey {
+    return [[[self getAction] all] minOfKey:anKey];
+}
+
++ (id)maxOf:(NSString *)anKey {
+    return [[[self getAction] all] maxOfKey:anKey];
+}
+
++ (NSNumber *)averageOf:(NSString *)anKey {
+    return [[[self getAction] all] averageOfKey:anKey];
 }
 
 #pragma mark - Private
 
 + (NSPredicate *)predicateFromDictionary:(NSDictionary *)dict {
-    NSMutableArray *subpredicates = [NSMutableArray new];
-    for (id key in [dict allKeys]) {
-        [subpredicates addObject:
-                [NSPredicate predicateWithFormat:@"%K == %@", key, dict[key]]
-        ];
-    }
-    return [NSCompoundPredicate andPredicateWithSubpredicates:subpredicates];
+    return [[JPDBManagerPredicateCache sharedCache] predicateMatchingDictionary:dict];
 }
 
 + (NSPredicate *)predicateFromObject:(id)condition {
@@ -153,7 +233,7 @@
         return condition;
 
     if ([condition isKindOfClass:[NSString class]])
-        return [NSPredicate predicateWithFormat:condition arguments:arguments];
+        return [[JPDBManagerPredicateCache sharedCache] predicateWithFormat:condition arguments:arguments];
 
     else if ([condition isKindOfClass:[NSDictionary class]])
         return [self predicateFromDictionary:condition];